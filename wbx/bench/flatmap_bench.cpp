@@ -0,0 +1,136 @@
+// SPDX-License-Identifier: GPL-2.0-only
+
+/*
+ * Symbol table lookups: std::unordered_map<std::string, ...> against
+ * FlatStrMap, keyed by OKX style instrument names (spot, swaps, dated
+ * futures and options).
+ *
+ * Lookups use string_views into one buffer like the frame parser does,
+ * so the unordered_map side has to build a std::string for each one.
+ *
+ *   wbx_flatmap_bench [nr_lookups] [miss_percent]
+ */
+
+#include <wbx/exc/FlatStrMap.hpp>
+
+#include <unordered_map>
+#include <string_view>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <random>
+#include <cstdio>
+#include <cstdlib>
+
+using wbx::exc::FlatStrMap;
+
+static const char *bases[] = {
+	"BTC", "ETH", "SOL", "XRP", "DOGE", "ADA", "AVAX", "LINK", "DOT", "TRX",
+	"LTC", "BCH", "UNI", "ATOM", "ETC", "FIL", "APT", "ARB", "OP", "NEAR",
+	"INJ", "SUI", "SEI", "TIA", "PEPE", "SHIB", "WLD", "AAVE", "MKR", "LDO",
+	"CRV", "SAND", "MANA", "AXS", "GALA", "IMX", "RNDR", "GRT", "STX", "ORDI",
+};
+
+static std::vector<std::string> instIds(void)
+{
+	static const char *expiries[] = { "250328", "250627", "250926", "251226" };
+	static const char *strikes[] = { "1000", "25000", "100000" };
+	std::vector<std::string> ret;
+
+	for (const char *b : bases) {
+		std::string base = b;
+
+		ret.push_back(base + "-USDT");
+		ret.push_back(base + "-USDC");
+		ret.push_back(base + "-USDT-SWAP");
+		ret.push_back(base + "-USD-SWAP");
+		for (const char *e : expiries) {
+			ret.push_back(base + "-USD-" + e);
+			for (const char *k : strikes) {
+				ret.push_back(base + "-USD-" + e + "-" + k + "-C");
+				ret.push_back(base + "-USD-" + e + "-" + k + "-P");
+			}
+		}
+	}
+
+	return ret;
+}
+
+template<typename F>
+static double run(const std::vector<std::string_view> &keys, uint64_t *sum, F lookup)
+{
+	auto start = std::chrono::steady_clock::now();
+	uint64_t s = 0;
+
+	for (const auto &k : keys)
+		s += lookup(k);
+
+	*sum = s;
+	return std::chrono::duration<double, std::nano>(
+		std::chrono::steady_clock::now() - start).count() / keys.size();
+}
+
+int main(int argc, char *argv[])
+{
+	size_t nr_lookups = (argc > 1) ? strtoul(argv[1], nullptr, 10) : 10000000;
+	unsigned miss_pct = (argc > 2) ? (unsigned)strtoul(argv[2], nullptr, 10) : 10;
+	std::vector<std::string> names = instIds();
+	std::unordered_map<std::string, uint64_t> umap;
+	FlatStrMap<uint64_t> fmap;
+	std::vector<std::string_view> keys;
+	std::string frame;
+	std::mt19937_64 rng(1);
+	uint64_t sum_u, sum_f;
+	double ns_u, ns_f;
+	size_t i;
+
+	for (i = 0; i < names.size(); i++) {
+		umap.emplace(names[i], i + 1);
+		fmap.emplace(names[i], i + 1);
+	}
+
+	// Missing keys: unknown quotes of known bases.
+	for (const char *b : bases)
+		names.push_back(std::string(b) + "-EUR");
+
+	std::vector<size_t> offs;
+	for (const auto &n : names) {
+		offs.push_back(frame.size());
+		frame += n;
+	}
+
+	keys.reserve(nr_lookups);
+	for (i = 0; i < nr_lookups; i++) {
+		size_t nr_hit = names.size() - sizeof(bases) / sizeof(bases[0]);
+		size_t idx;
+
+		if (rng() % 100 < miss_pct)
+			idx = nr_hit + rng() % (names.size() - nr_hit);
+		else
+			idx = rng() % nr_hit;
+
+		keys.emplace_back(frame.data() + offs[idx], names[idx].size());
+	}
+
+	ns_u = run(keys, &sum_u, [&umap](std::string_view k) -> uint64_t {
+		auto it = umap.find(std::string(k));
+		return it == umap.end() ? 0 : it->second;
+	});
+
+	ns_f = run(keys, &sum_f, [&fmap](std::string_view k) -> uint64_t {
+		auto it = fmap.find(k);
+		return it == fmap.end() ? 0 : it->second;
+	});
+
+	printf("instruments: %zu, lookups: %zu, misses: %u%%\n",
+	       umap.size(), nr_lookups, miss_pct);
+	printf("unordered_map: %.1f ns/lookup\n", ns_u);
+	printf("FlatStrMap:    %.1f ns/lookup\n", ns_f);
+
+	if (sum_u != sum_f) {
+		printf("result mismatch\n");
+		return 1;
+	}
+
+	return 0;
+}
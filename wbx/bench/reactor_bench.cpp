@@ -0,0 +1,319 @@
+// SPDX-License-Identifier: GPL-2.0-only
+
+/*
+ * Websocket frame round trips through WebsocketSession and the Asio
+ * reactor the library is built with (epoll by default, io_uring with
+ * -DWBX_IO_URING=ON).
+ *
+ * A forked child runs a TLS websocket echo server on loopback, so the
+ * counters of this process only cover the client: the frame RTT
+ * percentiles, and the syscalls and context switches per round trip
+ * once the handshake is done. Syscalls are counted through the
+ * raw_syscalls:sys_enter tracepoint, which needs tracefs and
+ * perf_event_paranoid <= 1 (or root); without it they are left out.
+ *
+ *   wbx_reactor_bench [nr_msgs] [msg_size]
+ */
+
+#include <boost/asio.hpp>
+#include <boost/asio/ssl.hpp>
+#include <boost/beast/core.hpp>
+#include <boost/beast/ssl.hpp>
+#include <boost/beast/websocket.hpp>
+#include <boost/beast/websocket/ssl.hpp>
+#include <openssl/ec.h>
+#include <openssl/evp.h>
+#include <openssl/x509.h>
+#include <wbx/exc/Websocket.hpp>
+#include <wbx/exc/Histogram.hpp>
+
+#include <linux/perf_event.h>
+#include <sys/syscall.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <signal.h>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <chrono>
+#include <future>
+#include <string>
+
+namespace net = boost::asio;
+namespace ssl = boost::asio::ssl;
+namespace beast = boost::beast;
+namespace websocket = boost::beast::websocket;
+using tcp = boost::asio::ip::tcp;
+using namespace wbx::exc;
+
+static inline uint64_t nowNs(void)
+{
+	return std::chrono::duration_cast<std::chrono::nanoseconds>(
+		std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// Throwaway P-256 key and certificate, the client runs with
+// WsTlsOpts::verify off.
+static void selfSign(ssl::context &ctx)
+{
+	EVP_PKEY_CTX *kctx = EVP_PKEY_CTX_new_id(EVP_PKEY_EC, nullptr);
+	EVP_PKEY *key = nullptr;
+	X509 *crt = X509_new();
+	X509_NAME *name;
+
+	if (!kctx || !crt || EVP_PKEY_keygen_init(kctx) <= 0 ||
+	    EVP_PKEY_CTX_set_ec_paramgen_curve_nid(kctx, NID_X9_62_prime256v1) <= 0 ||
+	    EVP_PKEY_keygen(kctx, &key) <= 0)
+		throw std::runtime_error("Failed to generate the server key");
+
+	X509_set_version(crt, 2);
+	ASN1_INTEGER_set(X509_get_serialNumber(crt), 1);
+	X509_gmtime_adj(X509_getm_notBefore(crt), 0);
+	X509_gmtime_adj(X509_getm_notAfter(crt), 3600);
+	X509_set_pubkey(crt, key);
+	name = X509_get_subject_name(crt);
+	X509_NAME_add_entry_by_txt(name, "CN", MBSTRING_ASC,
+				   (const unsigned char *)"localhost", -1, -1, 0);
+	X509_set_issuer_name(crt, name);
+
+	if (!X509_sign(crt, key, EVP_sha256()) ||
+	    SSL_CTX_use_certificate(ctx.native_handle(), crt) != 1 ||
+	    SSL_CTX_use_PrivateKey(ctx.native_handle(), key) != 1)
+		throw std::runtime_error("Failed to set up the server certificate");
+
+	X509_free(crt);
+	EVP_PKEY_free(key);
+	EVP_PKEY_CTX_free(kctx);
+}
+
+// Child process: echo every frame of one client back.
+static void echoServer(tcp::acceptor &acc)
+{
+	ssl::context ctx(ssl::context::tls_server);
+	beast::flat_buffer buf;
+	beast::error_code ec;
+
+	selfSign(ctx);
+
+	websocket::stream<beast::ssl_stream<tcp::socket>> ws(acc.accept(), ctx);
+	acc.close();
+	beast::get_lowest_layer(ws).set_option(tcp::no_delay(true));
+	ws.next_layer().handshake(ssl::stream_base::server);
+	ws.accept();
+
+	while (1) {
+		ws.read(buf, ec);
+		if (ec)
+			break;
+
+		ws.text(ws.got_text());
+		ws.write(buf.data(), ec);
+		if (ec)
+			break;
+
+		buf.consume(buf.size());
+	}
+}
+
+// Syscalls entered by this process and the threads it starts later, -1
+// if the tracepoint is not available.
+static int openSyscallCounter(void)
+{
+	static const char *paths[] = {
+		"/sys/kernel/tracing/events/raw_syscalls/sys_enter/id",
+		"/sys/kernel/debug/tracing/events/raw_syscalls/sys_enter/id",
+	};
+	struct perf_event_attr attr;
+	unsigned long long id = 0;
+	bool found = false;
+
+	for (const char *p : paths) {
+		FILE *f = fopen(p, "r");
+
+		if (!f)
+			continue;
+
+		found = fscanf(f, "%llu", &id) == 1;
+		fclose(f);
+		if (found)
+			break;
+	}
+
+	if (!found)
+		return -1;
+
+	memset(&attr, 0, sizeof(attr));
+	attr.type = PERF_TYPE_TRACEPOINT;
+	attr.size = sizeof(attr);
+	attr.config = id;
+	attr.inherit = 1;
+
+	return (int)syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0);
+}
+
+static uint64_t readCounter(int fd)
+{
+	uint64_t v = 0;
+
+	if (fd < 0 || read(fd, &v, sizeof(v)) != sizeof(v))
+		return 0;
+
+	return v;
+}
+
+struct Sample {
+	uint64_t	ns;
+	uint64_t	nr_syscalls;
+	long		nvcsw;
+	long		nivcsw;
+};
+
+static Sample sample(int sys_fd)
+{
+	struct rusage ru;
+	Sample s;
+
+	getrusage(RUSAGE_SELF, &ru);
+	s.ns = nowNs();
+	s.nr_syscalls = readCounter(sys_fd);
+	s.nvcsw = ru.ru_nvcsw;
+	s.nivcsw = ru.ru_nivcsw;
+	return s;
+}
+
+int main(int argc, char *argv[])
+{
+	size_t nr_msgs = (argc > 1) ? strtoul(argv[1], nullptr, 10) : 100000;
+	size_t msg_size = (argc > 2) ? strtoul(argv[2], nullptr, 10) : 256;
+	std::promise<bool> done;
+	std::string msg(msg_size, 'x');
+	LatencyHistogram hist;
+	uint64_t sent_ns = 0;
+	size_t left = nr_msgs;
+	bool finished = false;
+	Sample start, end;
+	WsTlsOpts tls;
+	uint16_t port;
+	int sys_fd;
+	pid_t pid;
+
+	if (!nr_msgs)
+		return 1;
+
+	// Fork before any thread exists.
+	{
+		net::io_context ioc;
+		tcp::acceptor acc(ioc, tcp::endpoint(net::ip::address_v4::loopback(), 0));
+
+		port = acc.local_endpoint().port();
+		pid = fork();
+		if (pid < 0) {
+			perror("fork");
+			return 1;
+		}
+
+		if (!pid) {
+			ioc.notify_fork(net::execution_context::fork_child);
+			try {
+				echoServer(acc);
+			} catch (const std::exception &e) {
+				fprintf(stderr, "echo server: %s\n", e.what());
+			}
+			_exit(0);
+		}
+	}
+
+	sys_fd = openSyscallCounter();
+	tls.verify = false;
+
+	Websocket ws(Websocket::createTlsCtx(tls));
+	WebsocketSession *sess = ws.createSession("127.0.0.1", port, "/");
+	WsSockOpts so;
+
+	so.tcp_nodelay = 1;
+	sess->setSockOpts(so);
+
+	auto send = [&]() {
+		sent_ns = nowNs();
+		sess->write(msg);
+	};
+
+	// io thread only. Killing the server later fails the connection.
+	auto finish = [&](bool ok) {
+		if (finished)
+			return;
+
+		finished = true;
+		done.set_value(ok);
+	};
+
+	sess->setOnConnect([&](WebsocketSession *) {
+		start = sample(sys_fd);
+		send();
+	});
+
+	sess->setOnWrite([](WebsocketSession *s, size_t len) {
+		s->read();
+		(void)len;
+	});
+
+	sess->setOnRead([&](WebsocketSession *, const char *data, size_t len) -> size_t {
+		hist.record(nowNs() - sent_ns);
+		(void)data;
+
+		if (--left) {
+			send();
+		} else {
+			end = sample(sys_fd);
+			finish(true);
+		}
+		return len;
+	});
+
+	sess->setOnConnErr([&](WebsocketSession *, int code, const char *err) {
+		if (!finished)
+			fprintf(stderr, "connection error %d: %s\n", code, err);
+		finish(false);
+	});
+
+	sess->run();
+	ws.bgRun();
+
+	bool ok = done.get_future().get();
+
+	kill(pid, SIGTERM);
+	waitpid(pid, nullptr, 0);
+
+	if (ok) {
+#ifdef BOOST_ASIO_HAS_IO_URING
+		printf("reactor: io_uring\n");
+#else
+		printf("reactor: default\n");
+#endif
+		printf("frames: %zu x %zu bytes, %.3f s\n", nr_msgs, msg_size,
+		       (end.ns - start.ns) / 1e9);
+		printf("rtt ns: mean %llu, p50 < %llu, p90 < %llu, p99 < %llu, p99.9 < %llu, max %llu\n",
+		       (unsigned long long)hist.mean(),
+		       (unsigned long long)hist.percentile(50),
+		       (unsigned long long)hist.percentile(90),
+		       (unsigned long long)hist.percentile(99),
+		       (unsigned long long)hist.percentile(99.9),
+		       (unsigned long long)hist.max());
+
+		if (sys_fd >= 0)
+			printf("syscalls per round trip: %.2f\n",
+			       (double)(end.nr_syscalls - start.nr_syscalls) / nr_msgs);
+		else
+			printf("syscalls per round trip: n/a (no raw_syscalls tracepoint)\n");
+
+		printf("ctx switches per round trip: voluntary %.2f, involuntary %.2f\n",
+		       (double)(end.nvcsw - start.nvcsw) / nr_msgs,
+		       (double)(end.nivcsw - start.nivcsw) / nr_msgs);
+	}
+
+	// Websocket has no stop(), its destructor would wait on the io
+	// thread forever.
+	fflush(stdout);
+	_exit(ok ? 0 : 1);
+}
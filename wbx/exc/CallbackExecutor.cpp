@@ -0,0 +1,270 @@
+// SPDX-License-Identifier: GPL-2.0-only
+
+#include <wbx/exc/CallbackExecutor.hpp>
+#include <chrono>
+
+namespace wbx {
+namespace exc {
+
+CallbackExecutor::CallbackExecutor(size_t nr_workers):
+	nr_runnable_(0),
+	stop_(false),
+	nr_steals_(0),
+	nr_slow_(0)
+{
+	size_t i;
+
+	if (!nr_workers)
+		nr_workers = std::thread::hardware_concurrency();
+	if (!nr_workers)
+		nr_workers = 1;
+
+	for (i = 0; i < nr_id_chunks; i++)
+		id_chunks_[i].store(nullptr, std::memory_order_relaxed);
+
+	for (i = 0; i < nr_workers; i++)
+		workers_.push_back(std::make_unique<Worker>());
+
+	for (i = 0; i < nr_workers; i++)
+		workers_[i]->thread = std::thread([this, i]() { workerLoop(i); });
+}
+
+CallbackExecutor::~CallbackExecutor(void)
+{
+	{
+		std::lock_guard<std::mutex> lock(idle_mtx_);
+		stop_.store(true);
+	}
+	idle_cv_.notify_all();
+
+	for (auto &w : workers_)
+		w->thread.join();
+
+	for (auto &c : id_chunks_) {
+		IdChunk *chunk = c.load(std::memory_order_relaxed);
+
+		if (!chunk)
+			continue;
+
+		for (auto &kq : chunk->kq)
+			delete kq.load(std::memory_order_relaxed);
+		delete chunk;
+	}
+}
+
+void CallbackExecutor::setSlowThreshold(uint64_t ns, SlowCb_t cb)
+{
+	slow_ns_ = ns;
+	slow_cb_ = std::move(cb);
+}
+
+inline CallbackExecutor::KeyQueue *CallbackExecutor::getKeyQueue(const std::string &key)
+{
+	std::lock_guard<std::mutex> lock(keys_mtx_);
+	auto &kq = keys_[key];
+
+	if (!kq) {
+		kq = std::make_unique<KeyQueue>();
+		kq->key = key;
+		kq->home = std::hash<std::string>{}(key) % workers_.size();
+	}
+
+	return kq.get();
+}
+
+inline CallbackExecutor::KeyQueue *CallbackExecutor::getIdQueue(uint64_t id)
+{
+	std::atomic<IdChunk *> &c = id_chunks_[id / id_chunk_size];
+	IdChunk *chunk = c.load(std::memory_order_acquire);
+	KeyQueue *kq, *cur;
+	size_t i;
+
+	if (!chunk) {
+		IdChunk *fresh = new IdChunk;
+
+		for (i = 0; i < id_chunk_size; i++)
+			fresh->kq[i].store(nullptr, std::memory_order_relaxed);
+
+		// Lost the race, chunk now holds the winner's.
+		if (c.compare_exchange_strong(chunk, fresh, std::memory_order_acq_rel))
+			chunk = fresh;
+		else
+			delete fresh;
+	}
+
+	std::atomic<KeyQueue *> &slot = chunk->kq[id % id_chunk_size];
+	kq = slot.load(std::memory_order_acquire);
+	if (kq)
+		return kq;
+
+	kq = new KeyQueue();
+	kq->key = std::to_string(id);
+	kq->home = id % workers_.size();
+
+	cur = nullptr;
+	if (slot.compare_exchange_strong(cur, kq, std::memory_order_acq_rel))
+		return kq;
+
+	delete kq;
+	return cur;
+}
+
+inline void CallbackExecutor::pushRunq(size_t idx, KeyQueue *kq)
+{
+	Worker &w = *workers_[idx];
+
+	{
+		std::lock_guard<std::mutex> lock(w.mtx);
+		w.runq.push_back(kq);
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(idle_mtx_);
+		nr_runnable_.fetch_add(1);
+	}
+	idle_cv_.notify_one();
+}
+
+inline CallbackExecutor::KeyQueue *CallbackExecutor::popLocal(size_t idx)
+{
+	Worker &w = *workers_[idx];
+	std::lock_guard<std::mutex> lock(w.mtx);
+	KeyQueue *kq;
+
+	if (w.runq.empty())
+		return nullptr;
+
+	kq = w.runq.front();
+	w.runq.pop_front();
+	nr_runnable_.fetch_sub(1);
+	return kq;
+}
+
+inline CallbackExecutor::KeyQueue *CallbackExecutor::steal(size_t idx)
+{
+	size_t i, n = workers_.size();
+
+	for (i = 1; i < n; i++) {
+		Worker &w = *workers_[(idx + i) % n];
+		std::lock_guard<std::mutex> lock(w.mtx);
+		KeyQueue *kq;
+
+		if (w.runq.empty())
+			continue;
+
+		kq = w.runq.back();
+		w.runq.pop_back();
+		nr_runnable_.fetch_sub(1);
+		nr_steals_.fetch_add(1, std::memory_order_relaxed);
+		return kq;
+	}
+
+	return nullptr;
+}
+
+inline void CallbackExecutor::runTask(KeyQueue *kq, Task_t &task)
+{
+	auto start = std::chrono::steady_clock::now();
+	uint64_t ns;
+
+	task();
+
+	ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+		std::chrono::steady_clock::now() - start).count();
+	exec_hist_.record(ns);
+
+	if (slow_ns_ && ns >= slow_ns_) {
+		nr_slow_.fetch_add(1, std::memory_order_relaxed);
+		if (slow_cb_)
+			slow_cb_(kq->key, ns);
+	}
+}
+
+inline void CallbackExecutor::runKeyQueue(size_t idx, KeyQueue *kq)
+{
+	size_t n;
+
+	for (n = 0; n < max_batch; n++) {
+		Task_t task;
+
+		{
+			std::lock_guard<std::mutex> lock(kq->mtx);
+			if (kq->tasks.empty()) {
+				kq->scheduled = false;
+				return;
+			}
+
+			task = std::move(kq->tasks.front());
+			kq->tasks.pop_front();
+		}
+
+		runTask(kq, task);
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(kq->mtx);
+		if (kq->tasks.empty()) {
+			kq->scheduled = false;
+			return;
+		}
+	}
+
+	// Still busy, go to the back so other keys get their turn.
+	pushRunq(idx, kq);
+}
+
+void CallbackExecutor::workerLoop(size_t idx)
+{
+	while (1) {
+		KeyQueue *kq = popLocal(idx);
+
+		if (!kq)
+			kq = steal(idx);
+
+		if (kq) {
+			runKeyQueue(idx, kq);
+			continue;
+		}
+
+		std::unique_lock<std::mutex> lock(idle_mtx_);
+		idle_cv_.wait(lock, [this]() {
+			return nr_runnable_.load() > 0 || stop_.load();
+		});
+
+		if (stop_.load() && nr_runnable_.load() == 0)
+			break;
+	}
+}
+
+inline void CallbackExecutor::postTo(KeyQueue *kq, Task_t task)
+{
+	{
+		std::lock_guard<std::mutex> lock(kq->mtx);
+		kq->tasks.push_back(std::move(task));
+		if (kq->scheduled)
+			return;
+
+		kq->scheduled = true;
+	}
+
+	pushRunq(kq->home, kq);
+}
+
+void CallbackExecutor::post(const std::string &key, Task_t task)
+{
+	postTo(getKeyQueue(key), std::move(task));
+}
+
+void CallbackExecutor::post(uint64_t id, Task_t task)
+{
+	// Beyond the table, fall back to the locked string keys.
+	if (id >= id_chunk_size * nr_id_chunks) {
+		post("#" + std::to_string(id), std::move(task));
+		return;
+	}
+
+	postTo(getIdQueue(id), std::move(task));
+}
+
+} /* namespace exc */
+} /* namespace wbx */
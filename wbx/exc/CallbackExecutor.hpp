@@ -0,0 +1,119 @@
+// SPDX-License-Identifier: GPL-2.0-only
+
+#ifndef EXC__CALLBACK_EXECUTOR__HPP
+#define EXC__CALLBACK_EXECUTOR__HPP
+
+#include <mutex>
+#include <deque>
+#include <atomic>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+#include <cstdint>
+#include <functional>
+#include <unordered_map>
+#include <condition_variable>
+
+#include <wbx/exc/Histogram.hpp>
+
+namespace wbx {
+namespace exc {
+
+/*
+ * Work-stealing executor with per-key ordering.
+ *
+ * Tasks posted with the same key run one at a time in posting order.
+ * Each key owns a queue that is scheduled on its home worker; idle
+ * workers steal whole key queues from the back of other workers' run
+ * queues, so ordering within a key is never broken by stealing.
+ */
+class CallbackExecutor {
+public:
+	typedef std::function<void(void)> Task_t;
+	typedef std::function<void(const std::string &key, uint64_t ns)> SlowCb_t;
+
+	// Max tasks run from one key before it yields to other keys.
+	constexpr static size_t max_batch = 64;
+
+private:
+	struct KeyQueue {
+		std::mutex		mtx;
+		std::deque<Task_t>	tasks;
+		bool			scheduled = false;
+		size_t			home = 0;
+		std::string		key;
+	};
+
+	struct Worker {
+		std::mutex		mtx;
+		std::deque<KeyQueue *>	runq;
+		std::thread		thread;
+	};
+
+	std::mutex	keys_mtx_;
+	std::unordered_map<std::string, std::unique_ptr<KeyQueue>> keys_;
+
+	/*
+	 * Queues of integer keys, looked up without a lock. Chunks and
+	 * queues are created on first use and live as long as the executor.
+	 */
+	constexpr static size_t id_chunk_size = 1024;
+	constexpr static size_t nr_id_chunks = 1024;
+
+	struct IdChunk {
+		std::atomic<KeyQueue *>	kq[id_chunk_size];
+	};
+
+	std::atomic<IdChunk *>	id_chunks_[nr_id_chunks];
+	std::vector<std::unique_ptr<Worker>> workers_;
+
+	std::mutex		idle_mtx_;
+	std::condition_variable	idle_cv_;
+	std::atomic<size_t>	nr_runnable_;
+	std::atomic<bool>	stop_;
+
+	LatencyHistogram	exec_hist_;
+	std::atomic<uint64_t>	nr_steals_;
+	std::atomic<uint64_t>	nr_slow_;
+	uint64_t		slow_ns_ = 0;
+	SlowCb_t		slow_cb_ = nullptr;
+
+	inline KeyQueue *getKeyQueue(const std::string &key);
+	inline KeyQueue *getIdQueue(uint64_t id);
+	inline void postTo(KeyQueue *kq, Task_t task);
+	inline void pushRunq(size_t idx, KeyQueue *kq);
+	inline KeyQueue *popLocal(size_t idx);
+	inline KeyQueue *steal(size_t idx);
+	inline void runTask(KeyQueue *kq, Task_t &task);
+	inline void runKeyQueue(size_t idx, KeyQueue *kq);
+	void workerLoop(size_t idx);
+
+public:
+	// nr_workers == 0 means std::thread::hardware_concurrency().
+	explicit CallbackExecutor(size_t nr_workers = 0);
+	~CallbackExecutor(void);
+
+	void post(const std::string &key, Task_t task);
+
+	/*
+	 * post() for dense integer keys such as symbol ids. Lock-free and
+	 * allocation-free once the key was seen. Slow callbacks get the key
+	 * in decimal. Keys past the table go through the string keys as
+	 * "#<id>".
+	 */
+	void post(uint64_t id, Task_t task);
+
+	// Not thread-safe, call before the first post().
+	void setSlowThreshold(uint64_t ns, SlowCb_t cb);
+
+	inline size_t getNrWorkers(void) const { return workers_.size(); }
+	inline const LatencyHistogram &getExecHistogram(void) const { return exec_hist_; }
+	inline uint64_t getNrSteals(void) const { return nr_steals_.load(std::memory_order_relaxed); }
+	inline uint64_t getNrSlow(void) const { return nr_slow_.load(std::memory_order_relaxed); }
+};
+
+} /* namespace exc */
+} /* namespace wbx */
+
+#endif /* #ifndef EXC__CALLBACK_EXECUTOR__HPP */
@@ -1,6 +1,7 @@
 // SPDX-License-Identifier: GPL-2.0-only
 
 #include <wbx/exc/ExchangeFoundation.hpp>
+#include <wbx/exc/PriceFormat.hpp>
 #include <cstdio>
 #include <cstring>
 #include <cmath>
@@ -8,67 +9,107 @@
 namespace wbx {
 namespace exc {
 
-ExchangeFoundation::ExchangeFoundation(void) = default;
+static inline uint64_t nowNs(void)
+{
+	return std::chrono::duration_cast<std::chrono::nanoseconds>(
+		std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+ExchangeFoundation::ExchangeFoundation(void)
+{
+	shards_.push_back(std::make_unique<ExcShard>());
+	alive_ = std::make_shared<bool>(true);
+}
 
-ExchangeFoundation::~ExchangeFoundation(void) = default;
+ExchangeFoundation::~ExchangeFoundation(void)
+{
+	stopShards();
+}
 
 // static
 std::string ExchangeFoundation::formatPrice(uint64_t price, uint64_t prec)
 {
-	char *dst, *src;
-	size_t cp_len;
 	char buf[128];
-	size_t len;
-
-	len = (size_t)snprintf(buf, sizeof(buf), "%llu", (unsigned long long)price);
-	if (prec >= len) {
-		dst = &buf[prec - len + 2];
-		src = buf;
-		cp_len = len + 1;
-		memmove(dst, src, cp_len);
-		buf[0] = '0';
-		buf[1] = '.';
-		memset(buf + 2, '0', prec - len);
-	} else {
-		dst = buf + len - prec + 1;
-		src = buf + len - prec;
-		cp_len = prec + 1;
-		memmove(dst, src, cp_len);
-		buf[len - prec] = '.';
+
+	return std::string(buf, fmtFixed(buf, sizeof(buf), price, (uint32_t)prec));
+}
+
+inline ExcShard &ExchangeFoundation::getShard(uint32_t id)
+{
+	if (shards_.size() == 1)
+		return *shards_[0];
+
+	return *shards_[id % shards_.size()];
+}
+
+// Slot @idx of @v, nullptr if it was never used and !@create.
+template<typename T>
+static inline T *symSlot(std::vector<T> &v, size_t idx, bool create)
+{
+	if (idx >= v.size()) {
+		if (!create)
+			return nullptr;
+		v.resize(idx + 1);
 	}
 
-	return buf;
+	return &v[idx];
 }
 
-inline void ExchangeFoundation::__addPriceUpdateCb(const std::string &symbol,
-						   PriceUpdateCb_t cb, void *udata)
+uint32_t ExchangeFoundation::internSymbol(std::string_view symbol,
+					  std::string_view *name)
 {
-	m_price_update_cbs_[symbol] = {cb, udata};
+	std::lock_guard<lp_mutex_t> lock(sym_tab_mtx_);
+	auto ins = sym_ids_.emplace(symbol, (uint32_t)sym_names_.size());
+	uint32_t id = ins.first->second;
+
+	if (ins.second)
+		sym_names_.emplace_back(symbol);
+
+	if (name)
+		*name = sym_names_[id];
+	return id;
 }
 
+bool ExchangeFoundation::findSymbol(std::string_view symbol, uint32_t *id)
+{
+	std::lock_guard<lp_mutex_t> lock(sym_tab_mtx_);
+	auto it = sym_ids_.find(symbol);
 
-inline void ExchangeFoundation::addPriceUpdateCb(const std::string &symbol,
-						 PriceUpdateCb_t cb, void *udata)
+	if (it == sym_ids_.end())
+		return false;
+
+	*id = it->second;
+	return true;
+}
+
+std::string_view ExchangeFoundation::getSymbolName(uint32_t id)
 {
-	std::lock_guard<std::mutex> lock(m_price_update_cbs_mtx_);
-	__addPriceUpdateCb(symbol, cb, udata);
+	std::lock_guard<lp_mutex_t> lock(sym_tab_mtx_);
+
+	if (id >= sym_names_.size())
+		return {};
+
+	return sym_names_[id];
 }
 
-inline void ExchangeFoundation::__addPriceUpdateCbBatch(const std::vector<std::string> &symbols,
-							PriceUpdateCb_t cb, void *udata)
+inline void ExchangeFoundation::addPriceUpdateCb(const std::string &symbol,
+						 PriceUpdateCb_t cb, void *udata)
 {
-	for (const auto &symbol : symbols)
-		__addPriceUpdateCb(symbol, cb, udata);
+	uint32_t id = internSymbol(symbol);
+	ExcShard &sh = getShard(id);
+	std::lock_guard<lp_mutex_t> lock(sh.price_update_cbs_mtx);
+
+	symSlot(sh.subs, symIndex(id), true)->cb = {cb, udata};
 }
 
 inline void ExchangeFoundation::addPriceUpdateCbBatch(const std::vector<std::string> &symbols,
 							PriceUpdateCb_t cb, void *udata)
 {
-	std::lock_guard<std::mutex> lock(m_price_update_cbs_mtx_);
-	__addPriceUpdateCbBatch(symbols, cb, udata);
+	for (const auto &symbol : symbols)
+		addPriceUpdateCb(symbol, cb, udata);
 }
 
-inline void ExchangeFoundation::__addPriceUpdateCbBatch(const std::vector<std::string> &symbols,
+inline void ExchangeFoundation::addPriceUpdateCbBatch(const std::vector<std::string> &symbols,
 							std::vector<PriceUpdateCb_t> cbs,
 							std::vector<void *> udatas)
 {
@@ -79,38 +120,37 @@ inline void ExchangeFoundation::__addPriceUpdateCbBatch(const std::vector<std::s
 		throw std::runtime_error("Invalid arguments");
 
 	for (i = 0; i < n; i++)
-		__addPriceUpdateCb(symbols[i], cbs[i], udatas[i]);
+		addPriceUpdateCb(symbols[i], cbs[i], udatas[i]);
 }
 
-inline void ExchangeFoundation::addPriceUpdateCbBatch(const std::vector<std::string> &symbols,
-							std::vector<PriceUpdateCb_t> cbs,
-							std::vector<void *> udatas)
+inline void ExchangeFoundation::delPriceUpdateCb(const std::string &symbol)
 {
-	std::lock_guard<std::mutex> lock(m_price_update_cbs_mtx_);
-	__addPriceUpdateCbBatch(symbols, cbs, udatas);
-}
+	ExcSymSubs *s;
+	uint32_t id;
 
-inline void ExchangeFoundation::__delPriceUpdateCb(const std::string &symbol)
-{
-	m_price_update_cbs_.erase(symbol);
-}
+	if (!findSymbol(symbol, &id))
+		return;
 
-inline void ExchangeFoundation::delPriceUpdateCb(const std::string &symbol)
-{
-	std::lock_guard<std::mutex> lock(m_price_update_cbs_mtx_);
-	__delPriceUpdateCb(symbol);
-}
+	ExcShard &sh = getShard(id);
+	std::lock_guard<lp_mutex_t> lock(sh.price_update_cbs_mtx);
 
-inline void ExchangeFoundation::__delPriceUpdateCbBatch(const std::vector<std::string> &symbols)
-{
-	for (const auto &symbol : symbols)
-		__delPriceUpdateCb(symbol);
+	s = symSlot(sh.subs, symIndex(id), false);
+	if (!s)
+		return;
+
+	s->cb = {nullptr, nullptr};
+
+	// The caller unsubscribes.
+	if (s->kept_alive) {
+		sh.keep_lru.erase(s->keep_it);
+		s->kept_alive = false;
+	}
 }
 
 inline void ExchangeFoundation::delPriceUpdateCbBatch(const std::vector<std::string> &symbols)
 {
-	std::lock_guard<std::mutex> lock(m_price_update_cbs_mtx_);
-	__delPriceUpdateCbBatch(symbols);
+	for (const auto &symbol : symbols)
+		delPriceUpdateCb(symbol);
 }
 
 // static
@@ -178,13 +218,12 @@ void ExchangeFoundation::__setOHLCData(struct OHLCData &dt, uint64_t price,
 	}
 }
 
-// Must hold m_last_prices_mtx_ lock.
+// Must hold the last_prices_mtx lock of the shard of @og.
+// static
 inline
-void ExchangeFoundation::__setOHLCGroup(const std::string &symbol, uint64_t price,
+void ExchangeFoundation::__setOHLCGroup(struct OHLCGroup &og, uint64_t price,
 					uint64_t prec, uint64_t ts)
 {
-	struct OHLCGroup &og = m_ohlc_data_[symbol];
-
 	__setOHLCData(og.ohlc_1s, price, prec, ts, 1);
 	__setOHLCData(og.ohlc_1m, price, prec, ts, 60);
 	__setOHLCData(og.ohlc_5m, price, prec, ts, 300);
@@ -196,38 +235,26 @@ void ExchangeFoundation::__setOHLCGroup(const std::string &symbol, uint64_t pric
 }
 
 inline
-void ExchangeFoundation::setLastPrice(const std::string &symbol,
-				      const std::string &price_c,
+void ExchangeFoundation::setLastPrice(ExcShard &sh, uint32_t id,
+				      uint64_t price, uint32_t scale,
 				      uint64_t ts)
 {
-	std::lock_guard<std::mutex> lock(m_last_prices_mtx_);
-	auto it = m_precisions_.find(symbol);
-	std::string price = price_c;
-	uint64_t cur_price;
-	uint64_t cur_prec;
+	std::lock_guard<lp_mutex_t> lock(sh.last_prices_mtx);
+	ExcSymPrices &p = *symSlot(sh.prices, symIndex(id), true);
+	uint64_t cur_prec = scale;
 
-	auto dot = price.find('.');
-	if (dot == std::string::npos) {
-		cur_prec = 0;
-	} else {
-		cur_prec = price.size() - dot - 1;
-		price.erase(dot, 1);
-	}
-
-	if (it != m_precisions_.end()) {
-		uint64_t old_prec = it->second;
+	if (p.has_precision) {
+		uint64_t old_prec = p.precision;
 
 		if (cur_prec < old_prec) {
-			uint64_t i, prec_diff = old_prec - cur_prec;
-			for (i = 0; i < prec_diff; i++)
-				price += '0';
-
-			cur_prec = old_prec;
+			for (; cur_prec < old_prec; cur_prec++)
+				price *= 10;
 		} else if (cur_prec > old_prec) {
-			m_precisions_[symbol] = cur_prec;
+			p.precision = cur_prec;
 		}
 	} else {
-		m_precisions_[symbol] = cur_prec;
+		p.precision = cur_prec;
+		p.has_precision = true;
 	}
 
 	if (ts == 0) {
@@ -235,94 +262,310 @@ void ExchangeFoundation::setLastPrice(const std::string &symbol,
 			std::chrono::system_clock::now().time_since_epoch()).count();
 	}
 
-	cur_price = std::stoull(price);
-	m_last_prices_[symbol] = cur_price;
-	__setOHLCGroup(symbol, cur_price, cur_prec, ts);
+	p.last_price = price;
+	p.has_price = true;
+	__setOHLCGroup(p.ohlc, price, cur_prec, ts);
 }
 
 inline
-void ExchangeFoundation::delLastPrice(const std::string &symbol)
+void ExchangeFoundation::delLastPrice(uint32_t id)
 {
-	std::lock_guard<std::mutex> lock(m_last_prices_mtx_);
-	m_last_prices_.erase(symbol);
+	ExcShard &sh = getShard(id);
+	std::lock_guard<lp_mutex_t> lock(sh.last_prices_mtx);
+	ExcSymPrices *p = symSlot(sh.prices, symIndex(id), false);
+
+	if (p)
+		p->has_price = false;
 }
 
-void ExchangeFoundation::invokePriceUpdateCb(const ExcPriceUpdate &up)
+inline
+bool ExchangeFoundation::lastPriceOf(uint32_t id, uint64_t *price, uint64_t *prec)
+{
+	ExcShard &sh = getShard(id);
+	std::lock_guard<lp_mutex_t> lock(sh.last_prices_mtx);
+	ExcSymPrices *p = symSlot(sh.prices, symIndex(id), false);
+
+	if (!p || !p->has_price || !p->has_precision)
+		return false;
+
+	*price = p->last_price;
+	*prec = p->precision;
+	return true;
+}
+
+inline
+void ExchangeFoundation::dispatchPriceUpdateCb(const PriceUpdateCb_t &cb,
+					       const ExcPriceUpdate &up,
+					       void *udata)
+{
+	ExcPriceUpdate cp;
+
+	if (!cb_exec_) {
+		cb(this, up, udata);
+		return;
+	}
+
+	// The frame is gone by the time the task runs.
+	cp = up;
+	cp.raw = {};
+	nr_cb_pending_.fetch_add(1, std::memory_order_relaxed);
+	cb_exec_->post(up.symbol_id, [this, cb, cp, udata]() {
+		cb(this, cp, udata);
+		nr_cb_pending_.fetch_sub(1, std::memory_order_release);
+	});
+}
+
+void ExchangeFoundation::__keepAliveEvict(ExcShard &sh,
+					  std::list<ExcKeepAlive>::iterator it)
+{
+	uint32_t id = it->symbol_id;
+	ExcSymSubs &s = sh.subs[symIndex(id)];
+
+	s.kept_alive = false;
+	sh.keep_lru.erase(it);
+
+	if (s.cb.cb || !s.get_last_price_cbs.empty())
+		return;
+
+	queueSubChange({std::string(getSymbolName(id))}, false);
+	// Nothing updates it any more.
+	delLastPrice(id);
+}
+
+void ExchangeFoundation::__keepAliveExpire(ExcShard &sh, uint64_t now_ns)
+{
+	while (!sh.keep_lru.empty() && sh.keep_lru.back().expire_ns <= now_ns)
+		__keepAliveEvict(sh, std::prev(sh.keep_lru.end()));
+}
+
+// The slot of @id must exist.
+void ExchangeFoundation::__keepAliveTouch(ExcShard &sh, uint32_t id,
+					  uint64_t now_ns)
+{
+	ExcSymSubs &s = sh.subs[symIndex(id)];
+
+	if (s.kept_alive) {
+		s.keep_it->expire_ns = now_ns + keep_alive_ns_;
+		sh.keep_lru.splice(sh.keep_lru.begin(), sh.keep_lru, s.keep_it);
+		return;
+	}
+
+	sh.keep_lru.push_front({id, now_ns + keep_alive_ns_});
+	s.keep_it = sh.keep_lru.begin();
+	s.kept_alive = true;
+
+	while (sh.keep_lru.size() > keep_alive_max_)
+		__keepAliveEvict(sh, std::prev(sh.keep_lru.end()));
+}
+
+inline
+void ExchangeFoundation::keepAliveRefresh(ExcShard &sh, uint32_t id)
 {
-	std::unique_lock<std::mutex> lock(m_price_update_cbs_mtx_);
+	std::lock_guard<lp_mutex_t> lock(sh.price_update_cbs_mtx);
+	ExcSymSubs *s = symSlot(sh.subs, symIndex(id), false);
+
+	if (s && s->kept_alive)
+		__keepAliveTouch(sh, id, nowNs());
+}
+
+void ExchangeFoundation::processPriceUpdate(ExcShard &sh, const ExcPriceUpdate &up)
+{
+	std::unique_lock<lp_mutex_t> lock(sh.price_update_cbs_mtx);
+	size_t idx = symIndex(up.symbol_id);
+	ExcSymSubs *s;
+
+	if (!sh.keep_lru.empty())
+		__keepAliveExpire(sh, nowNs());
+
+	s = symSlot(sh.subs, idx, false);
+	if (!s)
+		return;
+
+	if (s->cb.cb) {
+		auto d = s->cb;
+		lock.unlock();
+		setLastPrice(sh, up.symbol_id, up.price, up.scale);
+		dispatchPriceUpdateCb(d.cb, up, d.udata);
+		lock.lock();
+	} else if (s->kept_alive ||
+		   (keep_alive_ns_ && !s->get_last_price_cbs.empty())) {
+		// Lets getLastPrice() answer from the cache while kept alive.
+		lock.unlock();
+		setLastPrice(sh, up.symbol_id, up.price, up.scale);
+		lock.lock();
+	}
+
+	// Slots move when the vector grows while unlocked.
+	s = &sh.subs[idx];
+	if (s->get_last_price_cbs.empty())
+		return;
+
+	while (!s->get_last_price_cbs.empty()) {
+		auto cb = s->get_last_price_cbs.front();
+		s->get_last_price_cbs.pop();
 
-	auto it = m_price_update_cbs_.find(up.symbol);
-	if (it != m_price_update_cbs_.end()) {
-		auto d = it->second;
 		lock.unlock();
-		setLastPrice(up.symbol, up.price);
-		d.cb(this, up, d.udata);
+		dispatchPriceUpdateCb(cb, up, nullptr);
 		lock.lock();
+		s = &sh.subs[idx];
 	}
 
+	if (s->cb.cb)
+		return;
+
+	if (keep_alive_ns_ && keep_alive_max_)
+		__keepAliveTouch(sh, up.symbol_id, nowNs());
+	else
+		queueSubChange({std::string(up.symbol)}, false);
+}
+
+void ExchangeFoundation::shardLoop(ExcShard *sh)
+{
+	constexpr static unsigned spin_limit = 4096;
+	ExcPriceUpdate up;
+	unsigned spins = 0;
+
 	while (1) {
-		auto it_get = m_get_last_price_cbs_.find(up.symbol);
-		if (it_get == m_get_last_price_cbs_.end())
-			break;
+		if (sh->queue.pop(up)) {
+			processPriceUpdate(*sh, up);
+			spins = 0;
+			continue;
+		}
 
-		auto &cbs = it_get->second;
-		if (cbs.empty()) {
-			m_get_last_price_cbs_.erase(up.symbol);
-			if (m_price_update_cbs_.find(up.symbol) == m_price_update_cbs_.end())
-				__unlistenPriceUpdate(up.symbol);
-			break;
+		if (++spins < spin_limit) {
+			std::this_thread::yield();
+			continue;
 		}
 
-		auto cb = cbs.front();
-		cbs.pop();
+		std::unique_lock<std::mutex> lock(sh->wait_mtx);
+		sh->sleeping.store(true);
+		std::atomic_thread_fence(std::memory_order_seq_cst);
+		sh->wait_cv.wait(lock, [sh]() {
+			return !sh->queue.empty() || sh->stop.load();
+		});
+		sh->sleeping.store(false);
 
-		lock.unlock();
-		cb(this, up, nullptr);
-		lock.lock();
+		if (sh->stop.load() && sh->queue.empty())
+			break;
+
+		spins = 0;
+	}
+}
+
+// Called from the io thread, which is the only producer of every shard queue.
+void ExchangeFoundation::invokePriceUpdateCb(const ExcPriceUpdate &up)
+{
+	ExcShard &sh = getShard(up.symbol_id);
+	ExcPriceUpdate tmp;
+
+	if (!sh.thread.joinable()) {
+		processPriceUpdate(sh, up);
+		return;
+	}
+
+	// Only the io thread may look at the frame.
+	tmp = up;
+	tmp.raw = {};
+	while (!sh.queue.push(std::move(tmp)))
+		std::this_thread::yield();
+
+	std::atomic_thread_fence(std::memory_order_seq_cst);
+	if (sh.sleeping.load()) {
+		std::lock_guard<std::mutex> lock(sh.wait_mtx);
+		sh.wait_cv.notify_one();
 	}
 }
 
+void ExchangeFoundation::setShards(size_t nr_shards, size_t queue_size)
+{
+	size_t i;
+
+	if (nr_shards == 0)
+		throw std::runtime_error("Invalid number of shards");
+
+	if (!LockPolicy::threaded && nr_shards > 1)
+		throw std::runtime_error("Sharding is not available in single-threaded builds");
+
+	// Slots are indexed by the number of shards.
+	if (shards_.size() != 1 || !shards_[0]->subs.empty() ||
+	    !shards_[0]->prices.empty())
+		throw std::runtime_error("Shards must be set before subscribing");
+
+	shards_.clear();
+	for (i = 0; i < nr_shards; i++)
+		shards_.push_back(std::make_unique<ExcShard>(queue_size));
+
+	if (nr_shards == 1)
+		return;
+
+	for (auto &sh : shards_) {
+		ExcShard *p = sh.get();
+		sh->thread = std::thread([this, p]() { shardLoop(p); });
+	}
+}
+
+void ExchangeFoundation::stopShards(void)
+{
+	alive_.reset();
+
+	for (auto &sh : shards_) {
+		if (!sh->thread.joinable())
+			continue;
+
+		{
+			std::lock_guard<std::mutex> lock(sh->wait_mtx);
+			sh->stop.store(true);
+		}
+		sh->wait_cv.notify_one();
+		sh->thread.join();
+	}
+
+	// The executor may outlive us, its tasks hold a raw this.
+	while (nr_cb_pending_.load(std::memory_order_acquire))
+		std::this_thread::yield();
+}
+
 inline
 void ExchangeFoundation::getLastPriceNoListen(const std::string &symbol,
 					      std::function<void(const std::string &)> cb)
 {
-	std::unique_lock<std::mutex> lock(m_price_update_cbs_mtx_);
-	std::queue<PriceUpdateCb_t> &cbs = m_get_last_price_cbs_[symbol];
-
-	cbs.push([cb](ExchangeFoundation *exc, const ExcPriceUpdate &up, void *udata) {
-		cb(up.price);
+	uint32_t id = internSymbol(symbol);
+	ExcShard &sh = getShard(id);
+	std::unique_lock<lp_mutex_t> lock(sh.price_update_cbs_mtx);
+	ExcSymSubs &s = *symSlot(sh.subs, symIndex(id), true);
+	bool first = s.get_last_price_cbs.empty();
+
+	s.get_last_price_cbs.push([cb](ExchangeFoundation *exc, const ExcPriceUpdate &up, void *udata) {
+		cb(up.priceStr());
 		(void)exc;
 		(void)udata;
 	});
 
-	if (m_price_update_cbs_.find(symbol) == m_price_update_cbs_.end())
-		__listenPriceUpdate(symbol);
+	// Concurrent lookups share the first one's subscription.
+	if (!first || s.kept_alive)
+		return;
+
+	if (!s.cb.cb)
+		queueSubChange({symbol}, true);
 }
 
 std::string ExchangeFoundation::getLastPrice(const std::string &symbol,
 					     std::function<void(const std::string &)> cb)
 {
-	std::unique_lock<std::mutex> lock(m_last_prices_mtx_);
 	uint64_t price, prec;
+	uint32_t id;
 
-	auto it_price = m_last_prices_.find(symbol);
-	auto it_prec = m_precisions_.find(symbol);
-	if (it_price == m_last_prices_.end() || it_prec == m_precisions_.end()) {
-		lock.unlock();
+	if (!findSymbol(symbol, &id) || !lastPriceOf(id, &price, &prec)) {
 		if (cb)
 			getLastPriceNoListen(symbol, cb);
 
 		return "";
 	}
-	price = it_price->second;
-	prec = it_prec->second;
-	lock.unlock();
 
-	std::string price_str;
-	if (prec == 0)
-		price_str = std::to_string(price);
-	else
-		price_str = formatPrice(price, prec);
+	if (keep_alive_ns_)
+		keepAliveRefresh(getShard(id), id);
+
+	std::string price_str = formatPrice(price, prec);
 
 	if (cb) {
 		cb(price_str);
@@ -344,24 +587,116 @@ void ExchangeFoundation::__unlistenPriceUpdateBatch(const std::vector<std::strin
 		__unlistenPriceUpdate(symbol);
 }
 
+void ExchangeFoundation::__listenPriceUpdateBatchAck(const std::vector<std::string> &symbols,
+						     SubDoneCb_t done)
+{
+	ExcSubResult res;
+
+	__listenPriceUpdateBatch(symbols);
+	res.ok = symbols;
+	if (done)
+		done(res);
+}
+
+void ExchangeFoundation::queueSubChange(const std::vector<std::string> &symbols,
+					bool add)
+{
+	std::lock_guard<lp_mutex_t> lock(sub_batch_mtx_);
+
+	if (!sub_batching_ || !ws_) {
+		if (add)
+			__listenPriceUpdateBatch(symbols);
+		else
+			__unlistenPriceUpdateBatch(symbols);
+		return;
+	}
+
+	for (const auto &s : symbols) {
+		auto ins = sub_batch_.emplace(s, 0);
+
+		if (ins.second)
+			sub_batch_order_.push_back(s);
+
+		/*
+		 * Only the last call counts. Netting a subscribe against an
+		 * unsubscribe would drop a change whenever the first of the
+		 * two was a no-op; the exchange skips what it already has.
+		 */
+		ins.first->second = add ? 1 : -1;
+	}
+
+	if (sub_flush_pending_)
+		return;
+
+	std::weak_ptr<bool> alive = alive_;
+	auto flush = [this, alive]() {
+		if (alive.lock())
+			flushSubChanges();
+	};
+
+	sub_flush_pending_ = true;
+	if (sub_batch_window_ms_)
+		ws_->runAfter(sub_batch_window_ms_, flush);
+	else
+		ws_->post(flush);
+}
+
+void ExchangeFoundation::flushSubChanges(void)
+{
+	std::vector<std::string> add, del;
+
+	{
+		std::lock_guard<lp_mutex_t> lock(sub_batch_mtx_);
+
+		for (const auto &s : sub_batch_order_) {
+			auto it = sub_batch_.find(s);
+
+			if (it->second > 0)
+				add.push_back(s);
+			else
+				del.push_back(s);
+		}
+
+		sub_batch_order_.clear();
+		sub_batch_.clear();
+		sub_flush_pending_ = false;
+	}
+
+	// Unsubscribes first, they free room on capped connections.
+	if (!del.empty())
+		__unlistenPriceUpdateBatch(del);
+	if (!add.empty())
+		__listenPriceUpdateBatch(add);
+}
+
+void ExchangeFoundation::setSubBatching(bool enable, uint64_t window_ms)
+{
+	if (!enable)
+		flushSubChanges();
+
+	std::lock_guard<lp_mutex_t> lock(sub_batch_mtx_);
+	sub_batching_ = enable;
+	sub_batch_window_ms_ = window_ms;
+}
+
 void ExchangeFoundation::listenPriceUpdate(const std::string &symbol,
 					   PriceUpdateCb_t cb, void *udata)
 {
 	addPriceUpdateCb(symbol, cb, udata);
-	__listenPriceUpdate(symbol);
+	queueSubChange({symbol}, true);
 }
 
 void ExchangeFoundation::unlistenPriceUpdate(const std::string &symbol)
 {
 	delPriceUpdateCb(symbol);
-	__unlistenPriceUpdate(symbol);
+	queueSubChange({symbol}, false);
 }
 
 void ExchangeFoundation::listenPriceUpdateBatch(const std::vector<std::string> &symbols,
 						PriceUpdateCb_t cb, void *udata)
 {
 	addPriceUpdateCbBatch(symbols, cb, udata);
-	__listenPriceUpdateBatch(symbols);
+	queueSubChange(symbols, true);
 }
 
 void ExchangeFoundation::listenPriceUpdateBatch(const std::vector<std::string> &symbols,
@@ -369,13 +704,103 @@ void ExchangeFoundation::listenPriceUpdateBatch(const std::vector<std::string> &
 						std::vector<void *> udatas)
 {
 	addPriceUpdateCbBatch(symbols, cbs, udatas);
-	__listenPriceUpdateBatch(symbols);
+	queueSubChange(symbols, true);
 }
 
 void ExchangeFoundation::unlistenPriceUpdateBatch(const std::vector<std::string> &symbols)
 {
 	delPriceUpdateCbBatch(symbols);
-	__unlistenPriceUpdateBatch(symbols);
+	queueSubChange(symbols, false);
+}
+
+void ExchangeFoundation::subRejected(const std::vector<std::string> &symbols)
+{
+	uint32_t id;
+
+	for (const auto &symbol : symbols) {
+		if (!findSymbol(symbol, &id))
+			continue;
+
+		delPriceUpdateCb(symbol);
+
+		ExcShard &sh = getShard(id);
+		std::lock_guard<lp_mutex_t> lock(sh.price_update_cbs_mtx);
+		ExcSymSubs *s = symSlot(sh.subs, symIndex(id), false);
+
+		if (s)
+			s->get_last_price_cbs = {};
+	}
+}
+
+std::vector<std::string> ExchangeFoundation::getSubscriptions(void)
+{
+	std::vector<std::string> ret;
+	size_t i, j, n = shards_.size();
+
+	for (i = 0; i < n; i++) {
+		ExcShard &sh = *shards_[i];
+		std::lock_guard<lp_mutex_t> lock(sh.price_update_cbs_mtx);
+
+		for (j = 0; j < sh.subs.size(); j++) {
+			if (sh.subs[j].cb.cb)
+				ret.emplace_back(getSymbolName((uint32_t)(j * n + i)));
+		}
+	}
+
+	return ret;
+}
+
+void ExchangeFoundation::setSubscriptions(const std::vector<std::string> &symbols,
+					  PriceUpdateCb_t cb, void *udata)
+{
+	std::unordered_set<std::string> want(symbols.begin(), symbols.end());
+	std::vector<std::string> add, del, keep;
+
+	for (auto &symbol : getSubscriptions()) {
+		if (want.erase(symbol))
+			keep.push_back(std::move(symbol));
+		else
+			del.push_back(std::move(symbol));
+	}
+
+	// Keep the caller's order.
+	for (const auto &symbol : symbols) {
+		if (want.erase(symbol))
+			add.push_back(symbol);
+	}
+
+	// Symbols that stay only get the new callback.
+	addPriceUpdateCbBatch(keep, cb, udata);
+
+	if (!del.empty())
+		unlistenPriceUpdateBatch(del);
+	if (!add.empty())
+		listenPriceUpdateBatch(add, cb, udata);
+}
+
+void ExchangeFoundation::listenPriceUpdateBatch(const std::vector<std::string> &symbols,
+						PriceUpdateCb_t cb, void *udata,
+						SubDoneCb_t done)
+{
+	addPriceUpdateCbBatch(symbols, cb, udata);
+
+	// Keep the order of earlier batched changes.
+	flushSubChanges();
+	__listenPriceUpdateBatchAck(symbols, std::move(done));
+}
+
+std::future<ExcSubResult>
+ExchangeFoundation::listenPriceUpdateBatchAsync(const std::vector<std::string> &symbols,
+						PriceUpdateCb_t cb, void *udata)
+{
+	auto pr = std::make_shared<std::promise<ExcSubResult>>();
+	std::future<ExcSubResult> ret = pr->get_future();
+
+	listenPriceUpdateBatch(symbols, cb, udata, [pr](const ExcSubResult &res) {
+		pr->set_value(res);
+	});
+
+	return ret;
 }
 
 void ExchangeFoundation::setWebsocket(std::shared_ptr<Websocket> ws)
@@ -386,22 +811,53 @@ void ExchangeFoundation::setWebsocket(std::shared_ptr<Websocket> ws)
 	ws_ = ws;
 }
 
+void ExchangeFoundation::setLastPriceKeepAlive(uint64_t ttl_ms, size_t max_symbols)
+{
+	keep_alive_ns_ = ttl_ms * 1000000ull;
+	keep_alive_max_ = max_symbols;
+}
+
+void ExchangeFoundation::setCallbackExecutor(std::shared_ptr<CallbackExecutor> exec)
+{
+	if (!LockPolicy::threaded)
+		throw std::runtime_error("Callback executor is not available in single-threaded builds");
+
+	if (cb_exec_ != nullptr)
+		throw std::runtime_error("Callback executor already set");
+
+	cb_exec_ = exec;
+}
+
 void ExchangeFoundation::dumpOHLCData(const std::string &symbol)
 {
 	static const char tred[] = "\033[31m";
 	static const char tgreen[] = "\033[32m";
-	const struct OHLCGroup &og = m_ohlc_data_[symbol];
-	const struct OHLCPrice &p = og.ohlc_1m.prices.back();
+	struct OHLCPrice p;
+	uint32_t id;
+
+	if (!findSymbol(symbol, &id))
+		return;
+
+	{
+		ExcShard &sh = getShard(id);
+		std::lock_guard<lp_mutex_t> lock(sh.last_prices_mtx);
+		ExcSymPrices *sp = symSlot(sh.prices, symIndex(id), false);
+
+		if (!sp || sp->ohlc.ohlc_1m.prices.empty())
+			return;
+
+		p = sp->ohlc.ohlc_1m.prices.back();
+	}
 
 	if (p.curr == p.prev)
 		return;
 
-	std::string open = formatPrice(p.open, p.prec);
-	std::string high = formatPrice(p.high, p.prec);
-	std::string low = formatPrice(p.low, p.prec);
-	std::string close = formatPrice(p.close, p.prec);
-	std::string curr = formatPrice(p.curr, p.prec);
-	std::string prev = formatPrice(p.prev, p.prec);
+	const uint64_t vals[] = { p.open, p.high, p.low, p.close, p.curr, p.prev };
+	const char *str[6];
+	char buf[512];
+
+	if (!fmtFixedBulk(buf, sizeof(buf), vals, 6, (uint32_t)p.prec, str))
+		return;
 
 	if (p.close > p.open)
 		printf("%s", tgreen);
@@ -410,8 +866,8 @@ void ExchangeFoundation::dumpOHLCData(const std::string &symbol)
 
 	printf("%s\033[0m | tso: %llu, cts: %llu, tsc: %llu, O: %s, H: %s, L: %s, C: %s, curr: %s, prev: %s",
 	       symbol.c_str(), (unsigned long long)p.ts_open, (unsigned long long)p.ts_last,
-	       (unsigned long long)p.ts_close, open.c_str(), high.c_str(), low.c_str(),
-	       close.c_str(), curr.c_str(), prev.c_str());
+	       (unsigned long long)p.ts_close, str[0], str[1], str[2], str[3],
+	       str[4], str[5]);
 
 	if (p.close != p.open) {
 		double diff = ((double)p.close - (double)p.open) / p.prec;
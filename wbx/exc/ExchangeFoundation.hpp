@@ -5,26 +5,69 @@
 
 #include <string>
 #include <mutex>
+#include <list>
+#include <deque>
 #include <queue>
+#include <atomic>
+#include <future>
 #include <memory>
+#include <thread>
 #include <functional>
-#include <unordered_map>
+#include <string_view>
+#include <type_traits>
+#include <unordered_set>
+#include <condition_variable>
 
 #include <wbx/exc/Websocket.hpp>
+#include <wbx/exc/LockPolicy.hpp>
+#include <wbx/exc/CallbackExecutor.hpp>
+#include <wbx/exc/SPSCQueue.hpp>
+#include <wbx/exc/PriceFormat.hpp>
+#include <wbx/exc/FlatStrMap.hpp>
 
 namespace wbx {
 namespace exc {
 
+/*
+ * One price tick, trivially copyable. @symbol points into the symbol
+ * table and stays valid. @raw is the price text in the received frame,
+ * only valid in a callback run inline on the io thread and empty when
+ * the update was handed to a shard thread or a callback executor.
+ */
 struct ExcPriceUpdate {
-	std::string	symbol;
-	std::string	price;
-	uint64_t	ts;
+	uint32_t		symbol_id;
+	std::string_view	symbol;
+	std::string_view	raw;
+	// price / 10^scale
+	uint64_t		price;
+	uint32_t		scale;
+	// Exchange time, milliseconds since the epoch.
+	uint64_t		ts;
+
+	inline std::string priceStr(void) const
+	{
+		char buf[64];
+
+		return std::string(buf, fmtFixed(buf, sizeof(buf), price, scale));
+	}
 };
 
+static_assert(std::is_trivially_copyable<ExcPriceUpdate>::value,
+	      "ExcPriceUpdate is copied through the shard queues");
+
 class ExchangeFoundation;
 
 typedef std::function<void(ExchangeFoundation *ef, const ExcPriceUpdate &up, void *udata)> PriceUpdateCb_t;
 
+// Outcome of a subscription request.
+struct ExcSubResult {
+	std::vector<std::string>				ok;
+	// Symbol and the exchange's error.
+	std::vector<std::pair<std::string, std::string>>	failed;
+};
+
+typedef std::function<void(const ExcSubResult &res)> SubDoneCb_t;
+
 struct PriceUpdateCbData {
 	PriceUpdateCb_t	cb;
 	void		*udata;
@@ -60,55 +103,163 @@ struct OHLCGroup {
 	struct OHLCData ohlc_1d;
 };
 
+// One-shot subscription kept open, see setLastPriceKeepAlive().
+struct ExcKeepAlive {
+	uint32_t	symbol_id;
+	uint64_t	expire_ns;
+};
+
+// Subscribers of one symbol, under ExcShard::price_update_cbs_mtx.
+struct ExcSymSubs {
+	// Empty cb if nobody listens.
+	PriceUpdateCbData			cb = {nullptr, nullptr};
+	std::queue<PriceUpdateCb_t>		get_last_price_cbs;
+	// Valid if kept_alive.
+	std::list<ExcKeepAlive>::iterator	keep_it;
+	bool					kept_alive = false;
+};
+
+// Prices of one symbol, under ExcShard::last_prices_mtx.
+struct ExcSymPrices {
+	uint64_t		last_price = 0;
+	uint64_t		precision = 0;
+	bool			has_price = false;
+	bool			has_precision = false;
+	struct OHLCGroup	ohlc;
+};
+
+/*
+ * Per-symbol state. Without sharding there is a single shard updated
+ * inline on the io thread. In sharded mode every shard is owned by its
+ * own thread and fed by the io thread through an SPSC queue.
+ *
+ * Symbols go to shard id % nr_shards and are indexed there by
+ * id / nr_shards, so a tick never hashes its symbol name.
+ */
+struct ExcShard {
+	lp_mutex_t price_update_cbs_mtx;
+	std::vector<ExcSymSubs> subs;
+	// Most recently used first, under price_update_cbs_mtx.
+	std::list<ExcKeepAlive> keep_lru;
+
+	lp_mutex_t last_prices_mtx;
+	std::vector<ExcSymPrices> prices;
+
+	// Sharded mode only.
+	SPSCQueue<ExcPriceUpdate>	queue;
+	std::thread			thread;
+	std::mutex			wait_mtx;
+	std::condition_variable		wait_cv;
+	std::atomic<bool>		sleeping;
+	std::atomic<bool>		stop;
+
+	inline explicit ExcShard(size_t queue_size = 2):
+		queue(queue_size),
+		sleeping(false),
+		stop(false)
+	{
+	}
+};
+
 class ExchangeFoundation {
 private:
-	std::mutex m_price_update_cbs_mtx_;
-	std::unordered_map<std::string, PriceUpdateCbData> m_price_update_cbs_;
-	std::unordered_map<std::string, std::queue<PriceUpdateCb_t>> m_get_last_price_cbs_;
+	std::vector<std::unique_ptr<ExcShard>> shards_;
+
+	std::shared_ptr<CallbackExecutor> cb_exec_ = nullptr;
+	// Tasks posted to cb_exec_ and not finished yet.
+	std::atomic<size_t> nr_cb_pending_{0};
+
+	// Subscription changes not passed to the exchange yet, see
+	// setSubBatching(). Last requested state, +1 subscribed, -1 not.
+	lp_mutex_t sub_batch_mtx_;
+	std::vector<std::string> sub_batch_order_;
+	FlatStrMap<int> sub_batch_;
+	bool sub_batching_ = true;
+	bool sub_flush_pending_ = false;
+	uint64_t sub_batch_window_ms_ = 0;
+
+	void queueSubChange(const std::vector<std::string> &symbols, bool add);
+
+	uint64_t keep_alive_ns_ = 30000000000ull;
+	size_t keep_alive_max_ = 256;
 
-	std::mutex m_last_prices_mtx_;
-	std::unordered_map<std::string, uint64_t> m_last_prices_;
-	std::unordered_map<std::string, uint64_t> m_precisions_;
-	std::unordered_map<std::string, struct OHLCGroup> m_ohlc_data_;
+	void __keepAliveTouch(ExcShard &sh, uint32_t id, uint64_t now_ns);
+	void __keepAliveEvict(ExcShard &sh, std::list<ExcKeepAlive>::iterator it);
+	void __keepAliveExpire(ExcShard &sh, uint64_t now_ns);
+	inline void keepAliveRefresh(ExcShard &sh, uint32_t id);
+
+	// Symbol table, ids index sym_names_. A deque does not move its
+	// elements, so views of the names stay valid. Never shrinks.
+	lp_mutex_t sym_tab_mtx_;
+	FlatStrMap<uint32_t> sym_ids_;
+	std::deque<std::string> sym_names_;
+
+	// Id of @symbol, false if it was never interned.
+	bool findSymbol(std::string_view symbol, uint32_t *id);
+
+	inline ExcShard &getShard(uint32_t id);
+	inline size_t symIndex(uint32_t id) const { return id / shards_.size(); }
+	void shardLoop(ExcShard *sh);
+	void processPriceUpdate(ExcShard &sh, const ExcPriceUpdate &up);
 
 	static void __setOHLCData(struct OHLCData &dt, uint64_t price,
 				  uint64_t prec, uint64_t ts, uint64_t tsec);
-	inline void __setOHLCGroup(const std::string &symbol, uint64_t price,
-				   uint64_t prec, uint64_t ts);
-	inline void setLastPrice(const std::string &symbol, const std::string &price,
-				 uint64_t ts = 0);
-	inline void delLastPrice(const std::string &symbol);
+	static inline void __setOHLCGroup(struct OHLCGroup &og, uint64_t price,
+					  uint64_t prec, uint64_t ts);
+	inline void setLastPrice(ExcShard &sh, uint32_t id, uint64_t price,
+				 uint32_t scale, uint64_t ts = 0);
+	inline void delLastPrice(uint32_t id);
+	inline bool lastPriceOf(uint32_t id, uint64_t *price, uint64_t *prec);
 
-	inline void __addPriceUpdateCbBatch(const std::vector<std::string> &symbols,
-					   PriceUpdateCb_t cb, void *udata = nullptr);
 	inline void addPriceUpdateCbBatch(const std::vector<std::string> &symbols,
 					   PriceUpdateCb_t cb, void *udata = nullptr);
-	inline void __addPriceUpdateCbBatch(const std::vector<std::string> &symbols,
-					   std::vector<PriceUpdateCb_t> cbs,
-					   std::vector<void *> udatas);
 	inline void addPriceUpdateCbBatch(const std::vector<std::string> &symbols,
 					   std::vector<PriceUpdateCb_t> cbs,
 					   std::vector<void *> udatas);
-	inline void __delPriceUpdateCbBatch(const std::vector<std::string> &symbols);
 	inline void delPriceUpdateCbBatch(const std::vector<std::string> &symbols);
-	inline void __addPriceUpdateCb(const std::string &symbol, PriceUpdateCb_t cb,
-				     void *udata = nullptr);
 	inline void addPriceUpdateCb(const std::string &symbol, PriceUpdateCb_t cb,
 				     void *udata = nullptr);
-	inline void __delPriceUpdateCb(const std::string &symbol);
 	inline void delPriceUpdateCb(const std::string &symbol);
 	inline void getLastPriceNoListen(const std::string &symbol,
 					 std::function<void(const std::string &)> cb);
+	inline void dispatchPriceUpdateCb(const PriceUpdateCb_t &cb,
+					  const ExcPriceUpdate &up, void *udata);
 
 protected:
 	std::shared_ptr<Websocket> ws_ = nullptr;
+	// Expires in stopShards(). Tasks deferred on ws_ hold a weak_ptr
+	// and return early once it is gone, ws_ may outlive us.
+	std::shared_ptr<bool> alive_;
 	void invokePriceUpdateCb(const ExcPriceUpdate &up);
 
+	// Id of @symbol, added on first use. @name is set to the stored copy.
+	uint32_t internSymbol(std::string_view symbol, std::string_view *name = nullptr);
+
+	// Joins the shard threads, waits for the callbacks still queued on
+	// the executor and expires alive_. Derived destructors must call
+	// this before their part of the object goes away.
+	void stopShards(void);
+
 	virtual void __listenPriceUpdate(const std::string &symbol) = 0;
 	virtual void __unlistenPriceUpdate(const std::string &symbol) = 0;
 	virtual void __listenPriceUpdateBatch(const std::vector<std::string> &symbols);
 	virtual void __unlistenPriceUpdateBatch(const std::vector<std::string> &symbols);
 
+	/*
+	 * Subscribe and call @done once the exchange confirmed or rejected
+	 * every symbol. The default reports success right away for
+	 * exchanges that do not acknowledge subscriptions.
+	 */
+	virtual void __listenPriceUpdateBatchAck(const std::vector<std::string> &symbols,
+						 SubDoneCb_t done);
+
+	/*
+	 * The exchange refused @symbols. Their callbacks are dropped, so
+	 * they no longer count as subscribed. Must not be called with an
+	 * exchange lock held.
+	 */
+	void subRejected(const std::vector<std::string> &symbols);
+
 public:
 	ExchangeFoundation(void);
 	virtual ~ExchangeFoundation(void);
@@ -126,10 +277,69 @@ public:
 				    std::vector<void *> udatas);
 	void unlistenPriceUpdateBatch(const std::vector<std::string> &symbols);
 
+	/*
+	 * Like listenPriceUpdateBatch(), plus @done with the symbols the
+	 * exchange accepted and rejected. @done runs on the io thread.
+	 */
+	void listenPriceUpdateBatch(const std::vector<std::string> &symbols,
+				    PriceUpdateCb_t cb, void *udata, SubDoneCb_t done);
+	std::future<ExcSubResult> listenPriceUpdateBatchAsync(const std::vector<std::string> &symbols,
+							      PriceUpdateCb_t cb, void *udata);
+
+	/*
+	 * Make @symbols the complete set of price subscriptions, all going
+	 * to @cb. Only the difference to the active set is subscribed and
+	 * unsubscribed; the exchange replays the set on reconnect.
+	 */
+	void setSubscriptions(const std::vector<std::string> &symbols,
+			      PriceUpdateCb_t cb, void *udata);
+	std::vector<std::string> getSubscriptions(void);
+
 	std::string getLastPrice(const std::string &symbol,
 				 std::function<void(const std::string &)> cb = nullptr);
 
 	void setWebsocket(std::shared_ptr<Websocket> ws);
+
+	// Name of an ExcPriceUpdate::symbol_id.
+	std::string_view getSymbolName(uint32_t id);
+
+	/*
+	 * getLastPrice() with a callback subscribes to symbols nobody
+	 * listens to. Keep such a subscription for @ttl_ms after the last
+	 * lookup, at most @max_symbols per shard, least recently used
+	 * dropped first. 0 unsubscribes once the callbacks ran. Must be
+	 * called before start().
+	 */
+	void setLastPriceKeepAlive(uint64_t ttl_ms, size_t max_symbols = 256);
+
+	/*
+	 * Collect listen / unlisten calls and hand them to the exchange as
+	 * one batch per io loop turn, or per @window_ms if non-zero. Only the
+	 * last change of a symbol in a batch is passed on, the exchange
+	 * skips symbols already in that state. On by default; without a
+	 * Websocket calls go through directly.
+	 */
+	void setSubBatching(bool enable, uint64_t window_ms = 0);
+	// Pass the pending changes to the exchange now.
+	void flushSubChanges(void);
+
+	/*
+	 * Run price update callbacks on @exec instead of the io thread.
+	 * Callbacks of the same symbol keep their order. Must be called
+	 * before start(). Not available in single-threaded builds.
+	 */
+	void setCallbackExecutor(std::shared_ptr<CallbackExecutor> exec);
+	inline CallbackExecutor *getCallbackExecutor(void) { return cb_exec_.get(); }
+
+	/*
+	 * Partition the per-symbol state across @nr_shards threads. Each
+	 * shard owns its last prices, OHLC series and subscribers. Must be
+	 * called before start() and before any subscription is made.
+	 * Not available in single-threaded builds.
+	 */
+	void setShards(size_t nr_shards, size_t queue_size = 4096);
+	inline size_t getNrShards(void) const { return shards_.size(); }
+
 	void dumpOHLCData(const std::string &symbol);
 
 	virtual void start(void) = 0;
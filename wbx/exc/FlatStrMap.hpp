@@ -0,0 +1,269 @@
+// SPDX-License-Identifier: GPL-2.0-only
+
+#ifndef EXC__FLAT_STR_MAP__HPP
+#define EXC__FLAT_STR_MAP__HPP
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+#include <utility>
+#include <functional>
+#include <type_traits>
+
+namespace wbx {
+namespace exc {
+
+/*
+ * Open-addressing hash map keyed by strings, for the per-symbol tables.
+ *
+ * Entries live in one array probed linearly. The hash of every slot is
+ * kept in a separate array, so a probe only touches a key whose hash
+ * matched. Keys up to 15 bytes sit in the entry through the libstdc++
+ * short-string buffer: most spot instIds and short swaps such as
+ * BTC-USDT-SWAP. Longer ones (PEOPLE-USDT-SWAP, dated futures, options)
+ * point to the heap. Lookups take a std::string_view and never build a
+ * temporary string.
+ *
+ * Inserting may move entries and invalidates iterators and references,
+ * erasing does not. The capacity is a power of two, kept at most 7/8
+ * used, erased slots included.
+ */
+template<typename V>
+class FlatStrMap {
+public:
+	struct Entry {
+		std::string	first;
+		V		second;
+	};
+
+private:
+	// hashes_[i] of an empty and of an erased slot, real hashes are
+	// moved out of this range.
+	static constexpr uint32_t EMPTY = 0;
+	static constexpr uint32_t ERASED = 1;
+	static constexpr size_t NPOS = SIZE_MAX;
+
+	std::vector<uint32_t>	hashes_;
+	std::vector<Entry>	slots_;
+	size_t			mask_ = 0;
+	size_t			size_ = 0;
+	// Slots not EMPTY.
+	size_t			used_ = 0;
+
+	static inline uint32_t hashOf(std::string_view key)
+	{
+		uint32_t h = (uint32_t)std::hash<std::string_view>{}(key);
+
+		return h > ERASED ? h : h + 2;
+	}
+
+	inline size_t lookup(std::string_view key, uint32_t h) const
+	{
+		size_t i;
+
+		if (slots_.empty())
+			return NPOS;
+
+		for (i = h & mask_;; i = (i + 1) & mask_) {
+			uint32_t s = hashes_[i];
+
+			if (s == EMPTY)
+				return NPOS;
+			if (s == h && slots_[i].first == key)
+				return i;
+		}
+	}
+
+	void rehash(size_t cap)
+	{
+		std::vector<uint32_t> hashes(cap, EMPTY);
+		std::vector<Entry> slots(cap);
+		size_t i, j, mask = cap - 1;
+
+		for (i = 0; i < slots_.size(); i++) {
+			if (hashes_[i] <= ERASED)
+				continue;
+
+			for (j = hashes_[i] & mask; hashes[j] != EMPTY; j = (j + 1) & mask)
+				;
+
+			hashes[j] = hashes_[i];
+			slots[j] = std::move(slots_[i]);
+		}
+
+		hashes_ = std::move(hashes);
+		slots_ = std::move(slots);
+		mask_ = mask;
+		used_ = size_;
+	}
+
+	inline void reserveOne(void)
+	{
+		size_t cap = 16;
+
+		if ((used_ + 1) * 8 <= slots_.size() * 7)
+			return;
+
+		// Sized by the live entries: a table filled up by erased
+		// slots is rebuilt, not grown.
+		while ((size_ + 1) * 2 > cap)
+			cap <<= 1;
+
+		rehash(cap);
+	}
+
+	template<bool Const>
+	class Iter {
+	private:
+		typedef typename std::conditional<Const, const FlatStrMap, FlatStrMap>::type map_t;
+		typedef typename std::conditional<Const, const Entry, Entry>::type entry_t;
+
+		map_t	*map_;
+		size_t	i_;
+
+		inline void skip(void)
+		{
+			while (i_ < map_->slots_.size() && map_->hashes_[i_] <= ERASED)
+				i_++;
+		}
+
+	public:
+		inline Iter(map_t *map, size_t i, bool do_skip = false):
+			map_(map),
+			i_(i)
+		{
+			if (do_skip)
+				skip();
+		}
+
+		inline entry_t &operator*(void) const { return map_->slots_[i_]; }
+		inline entry_t *operator->(void) const { return &map_->slots_[i_]; }
+		inline size_t index(void) const { return i_; }
+
+		inline Iter &operator++(void)
+		{
+			i_++;
+			skip();
+			return *this;
+		}
+
+		inline bool operator==(const Iter &o) const { return i_ == o.i_; }
+		inline bool operator!=(const Iter &o) const { return i_ != o.i_; }
+	};
+
+public:
+	typedef Iter<false>	iterator;
+	typedef Iter<true>	const_iterator;
+
+	inline iterator begin(void) { return iterator(this, 0, true); }
+	inline iterator end(void) { return iterator(this, slots_.size()); }
+	inline const_iterator begin(void) const { return const_iterator(this, 0, true); }
+	inline const_iterator end(void) const { return const_iterator(this, slots_.size()); }
+
+	inline size_t size(void) const { return size_; }
+	inline bool empty(void) const { return !size_; }
+
+	inline iterator find(std::string_view key)
+	{
+		size_t i = lookup(key, hashOf(key));
+
+		return i == NPOS ? end() : iterator(this, i);
+	}
+
+	inline const_iterator find(std::string_view key) const
+	{
+		size_t i = lookup(key, hashOf(key));
+
+		return i == NPOS ? end() : const_iterator(this, i);
+	}
+
+	inline size_t count(std::string_view key) const
+	{
+		return lookup(key, hashOf(key)) != NPOS;
+	}
+
+	// Like std::unordered_map::try_emplace().
+	template<typename... Args>
+	std::pair<iterator, bool> emplace(std::string_view key, Args &&...args)
+	{
+		uint32_t h = hashOf(key);
+		size_t i = lookup(key, h);
+
+		if (i != NPOS)
+			return { iterator(this, i), false };
+
+		reserveOne();
+		for (i = h & mask_; hashes_[i] > ERASED; i = (i + 1) & mask_)
+			;
+
+		if (hashes_[i] == EMPTY)
+			used_++;
+
+		hashes_[i] = h;
+		slots_[i].first.assign(key.data(), key.size());
+		slots_[i].second = V(std::forward<Args>(args)...);
+		size_++;
+		return { iterator(this, i), true };
+	}
+
+	inline V &operator[](std::string_view key)
+	{
+		return emplace(key).first->second;
+	}
+
+	// Returns the iterator to the next entry.
+	iterator erase(iterator pos)
+	{
+		size_t i = pos.index();
+
+		// Nothing probes past an empty slot, so this one can be too.
+		if (hashes_[(i + 1) & mask_] == EMPTY) {
+			hashes_[i] = EMPTY;
+			used_--;
+		} else {
+			hashes_[i] = ERASED;
+		}
+
+		slots_[i] = Entry();
+		size_--;
+		return iterator(this, i + 1, true);
+	}
+
+	inline size_t erase(std::string_view key)
+	{
+		iterator it = find(key);
+
+		if (it == end())
+			return 0;
+
+		erase(it);
+		return 1;
+	}
+
+	void clear(void)
+	{
+		hashes_.clear();
+		slots_.clear();
+		mask_ = 0;
+		size_ = 0;
+		used_ = 0;
+	}
+
+	void reserve(size_t n)
+	{
+		size_t cap = 16;
+
+		while (n * 8 > cap * 7)
+			cap <<= 1;
+
+		if (cap > slots_.size())
+			rehash(cap);
+	}
+};
+
+} /* namespace exc */
+} /* namespace wbx */
+
+#endif /* #ifndef EXC__FLAT_STR_MAP__HPP */
@@ -0,0 +1,74 @@
+// SPDX-License-Identifier: GPL-2.0-only
+
+#ifndef EXC__FUNC_REF__HPP
+#define EXC__FUNC_REF__HPP
+
+#include <cstddef>
+#include <utility>
+
+namespace wbx {
+namespace exc {
+
+template<typename Sig>
+class FuncRef;
+
+/*
+ * Non-owning callable reference: an object pointer plus a thunk.
+ *
+ * Unlike std::function it never allocates and costs one indirect call.
+ * When bound with bind<&T::method>(obj) the target is known at compile
+ * time, so the thunk can inline the method body. The referenced object
+ * must outlive the FuncRef.
+ */
+template<typename R, typename... Args>
+class FuncRef<R(Args...)> {
+private:
+	void	*obj_ = nullptr;
+	R	(*fn_)(void *obj, Args... args) = nullptr;
+
+	template<typename T, auto MemFn>
+	static R memberThunk(void *obj, Args... args)
+	{
+		return (static_cast<T *>(obj)->*MemFn)(std::forward<Args>(args)...);
+	}
+
+	template<typename F>
+	static R callableThunk(void *obj, Args... args)
+	{
+		return (*static_cast<F *>(obj))(std::forward<Args>(args)...);
+	}
+
+	inline FuncRef(void *obj, R (*fn)(void *, Args...)) noexcept:
+		obj_(obj),
+		fn_(fn)
+	{
+	}
+
+public:
+	FuncRef(void) noexcept = default;
+	inline FuncRef(std::nullptr_t) noexcept {}
+
+	template<auto MemFn, typename T>
+	static inline FuncRef bind(T *obj) noexcept
+	{
+		return FuncRef(static_cast<void *>(obj), &memberThunk<T, MemFn>);
+	}
+
+	template<typename F>
+	static inline FuncRef from(F &f) noexcept
+	{
+		return FuncRef(static_cast<void *>(&f), &callableThunk<F>);
+	}
+
+	inline R operator()(Args... args) const
+	{
+		return fn_(obj_, std::forward<Args>(args)...);
+	}
+
+	inline explicit operator bool(void) const noexcept { return fn_ != nullptr; }
+};
+
+} /* namespace exc */
+} /* namespace wbx */
+
+#endif /* #ifndef EXC__FUNC_REF__HPP */
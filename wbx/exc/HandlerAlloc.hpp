@@ -0,0 +1,183 @@
+// SPDX-License-Identifier: GPL-2.0-only
+
+#ifndef EXC__HANDLER_ALLOC__HPP
+#define EXC__HANDLER_ALLOC__HPP
+
+#include <new>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <type_traits>
+
+namespace wbx {
+namespace exc {
+
+struct HandlerAllocStats {
+	uint64_t	nr_arena_allocs;
+	uint64_t	nr_heap_allocs;
+};
+
+/*
+ * Fixed pool of handler memory slots owned by one session. Asio picks
+ * it up through the associated allocator of the completion handler, so
+ * the steady-state read/write loop recycles the same slots instead of
+ * going to the heap. Requests that do not fit fall back to operator new
+ * and are counted in nr_heap_allocs.
+ */
+class HandlerArena {
+public:
+	constexpr static size_t nr_slots = 8;
+	constexpr static size_t slot_size = 2048;
+
+private:
+	struct Slot {
+		alignas(std::max_align_t) unsigned char mem[slot_size];
+	};
+
+	Slot			slots_[nr_slots];
+	std::atomic<bool>	in_use_[nr_slots];
+	std::atomic<uint64_t>	nr_arena_allocs_;
+	std::atomic<uint64_t>	nr_heap_allocs_;
+
+public:
+	inline HandlerArena(void) noexcept:
+		nr_arena_allocs_(0),
+		nr_heap_allocs_(0)
+	{
+		for (auto &u : in_use_)
+			u.store(false, std::memory_order_relaxed);
+	}
+
+	HandlerArena(const HandlerArena &) = delete;
+	HandlerArena &operator=(const HandlerArena &) = delete;
+
+	inline void *allocate(size_t size)
+	{
+		size_t i;
+
+		if (size <= slot_size) {
+			for (i = 0; i < nr_slots; i++) {
+				if (in_use_[i].load(std::memory_order_relaxed))
+					continue;
+				if (in_use_[i].exchange(true, std::memory_order_acquire))
+					continue;
+
+				nr_arena_allocs_.fetch_add(1, std::memory_order_relaxed);
+				return slots_[i].mem;
+			}
+		}
+
+		nr_heap_allocs_.fetch_add(1, std::memory_order_relaxed);
+		return ::operator new(size);
+	}
+
+	inline void deallocate(void *p) noexcept
+	{
+		unsigned char *c = static_cast<unsigned char *>(p);
+		unsigned char *begin = slots_[0].mem;
+		unsigned char *end = begin + sizeof(slots_);
+
+		if (c >= begin && c < end) {
+			in_use_[(size_t)(c - begin) / sizeof(Slot)].store(false, std::memory_order_release);
+			return;
+		}
+
+		::operator delete(p);
+	}
+
+	inline HandlerAllocStats getStats(void) const noexcept
+	{
+		return {
+			nr_arena_allocs_.load(std::memory_order_relaxed),
+			nr_heap_allocs_.load(std::memory_order_relaxed)
+		};
+	}
+};
+
+template<typename T>
+class HandlerAllocator {
+private:
+	template<typename> friend class HandlerAllocator;
+	HandlerArena	*arena_;
+
+public:
+	typedef T value_type;
+
+	inline explicit HandlerAllocator(HandlerArena &arena) noexcept:
+		arena_(&arena)
+	{
+	}
+
+	template<typename U>
+	inline HandlerAllocator(const HandlerAllocator<U> &other) noexcept:
+		arena_(other.arena_)
+	{
+	}
+
+	inline T *allocate(size_t n) const
+	{
+		return static_cast<T *>(arena_->allocate(sizeof(T) * n));
+	}
+
+	inline void deallocate(T *p, size_t n) const noexcept
+	{
+		arena_->deallocate(p);
+		(void)n;
+	}
+
+	template<typename U>
+	inline bool operator==(const HandlerAllocator<U> &other) const noexcept
+	{
+		return arena_ == other.arena_;
+	}
+
+	template<typename U>
+	inline bool operator!=(const HandlerAllocator<U> &other) const noexcept
+	{
+		return arena_ != other.arena_;
+	}
+};
+
+/*
+ * Completion handler wrapper exposing HandlerAllocator as its
+ * associated allocator (allocator_type + get_allocator()).
+ */
+template<typename Handler>
+class AllocHandler {
+private:
+	HandlerArena	*arena_;
+	Handler		handler_;
+
+public:
+	typedef HandlerAllocator<Handler> allocator_type;
+
+	inline AllocHandler(HandlerArena &arena, Handler &&h):
+		arena_(&arena),
+		handler_(std::move(h))
+	{
+	}
+
+	inline allocator_type get_allocator(void) const noexcept
+	{
+		return allocator_type(*arena_);
+	}
+
+	template<typename... Args>
+	inline void operator()(Args &&...args)
+	{
+		handler_(std::forward<Args>(args)...);
+	}
+};
+
+template<typename Handler>
+static inline AllocHandler<typename std::decay<Handler>::type>
+makeAllocHandler(HandlerArena &arena, Handler &&h)
+{
+	return AllocHandler<typename std::decay<Handler>::type>(arena, std::forward<Handler>(h));
+}
+
+} /* namespace exc */
+} /* namespace wbx */
+
+#endif /* #ifndef EXC__HANDLER_ALLOC__HPP */
@@ -0,0 +1,101 @@
+// SPDX-License-Identifier: GPL-2.0-only
+
+#ifndef EXC__HISTOGRAM__HPP
+#define EXC__HISTOGRAM__HPP
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+namespace wbx {
+namespace exc {
+
+/*
+ * Lock-free log2 histogram for latency samples in nanoseconds.
+ *
+ * Bucket i counts samples in [2^i, 2^(i + 1)), bucket 0 also takes 0.
+ * Recording is safe from any thread; readers get a relaxed snapshot.
+ */
+class LatencyHistogram {
+public:
+	constexpr static size_t nr_buckets = 64;
+
+private:
+	std::atomic<uint64_t>	buckets_[nr_buckets];
+	std::atomic<uint64_t>	count_;
+	std::atomic<uint64_t>	sum_;
+	std::atomic<uint64_t>	max_;
+
+public:
+	inline LatencyHistogram(void) noexcept
+	{
+		reset();
+	}
+
+	inline void reset(void) noexcept
+	{
+		for (auto &b : buckets_)
+			b.store(0, std::memory_order_relaxed);
+
+		count_.store(0, std::memory_order_relaxed);
+		sum_.store(0, std::memory_order_relaxed);
+		max_.store(0, std::memory_order_relaxed);
+	}
+
+	inline void record(uint64_t ns) noexcept
+	{
+		size_t i = ns ? 63 - __builtin_clzll(ns) : 0;
+		uint64_t m;
+
+		buckets_[i].fetch_add(1, std::memory_order_relaxed);
+		count_.fetch_add(1, std::memory_order_relaxed);
+		sum_.fetch_add(ns, std::memory_order_relaxed);
+
+		m = max_.load(std::memory_order_relaxed);
+		while (ns > m && !max_.compare_exchange_weak(m, ns, std::memory_order_relaxed))
+			;
+	}
+
+	inline uint64_t count(void) const noexcept { return count_.load(std::memory_order_relaxed); }
+	inline uint64_t sum(void) const noexcept { return sum_.load(std::memory_order_relaxed); }
+	inline uint64_t max(void) const noexcept { return max_.load(std::memory_order_relaxed); }
+
+	inline uint64_t mean(void) const noexcept
+	{
+		uint64_t n = count();
+
+		return n ? sum() / n : 0;
+	}
+
+	inline uint64_t bucket(size_t i) const noexcept
+	{
+		return buckets_[i].load(std::memory_order_relaxed);
+	}
+
+	// Upper bound (exclusive) of the bucket holding the p-th percentile.
+	inline uint64_t percentile(double p) const noexcept
+	{
+		uint64_t n = count(), target, acc = 0;
+		size_t i;
+
+		if (!n)
+			return 0;
+
+		target = (uint64_t)((double)n * p / 100.0);
+		if (target == 0)
+			target = 1;
+
+		for (i = 0; i < nr_buckets; i++) {
+			acc += bucket(i);
+			if (acc >= target)
+				return (i == 63) ? UINT64_MAX : (2ull << i);
+		}
+
+		return max();
+	}
+};
+
+} /* namespace exc */
+} /* namespace wbx */
+
+#endif /* #ifndef EXC__HISTOGRAM__HPP */
@@ -0,0 +1,43 @@
+// SPDX-License-Identifier: GPL-2.0-only
+
+#ifndef EXC__LOCK_POLICY__HPP
+#define EXC__LOCK_POLICY__HPP
+
+#include <mutex>
+
+namespace wbx {
+namespace exc {
+
+struct NullMutex {
+	inline void lock(void) noexcept {}
+	inline void unlock(void) noexcept {}
+	inline bool try_lock(void) noexcept { return true; }
+};
+
+struct MtLockPolicy {
+	typedef std::mutex mutex_t;
+	constexpr static bool threaded = true;
+};
+
+/*
+ * Everything runs on the single io thread: the locks and the session
+ * strands compile to nothing. Calls into ExchangeFoundation and
+ * Websocket must then come from the io thread (or before run()).
+ */
+struct StLockPolicy {
+	typedef NullMutex mutex_t;
+	constexpr static bool threaded = false;
+};
+
+#ifdef WBX_SINGLE_THREADED
+typedef StLockPolicy LockPolicy;
+#else
+typedef MtLockPolicy LockPolicy;
+#endif
+
+typedef LockPolicy::mutex_t lp_mutex_t;
+
+} /* namespace exc */
+} /* namespace wbx */
+
+#endif /* #ifndef EXC__LOCK_POLICY__HPP */
@@ -0,0 +1,155 @@
+// SPDX-License-Identifier: GPL-2.0-only
+
+#ifndef EXC__PRICE_FORMAT__HPP
+#define EXC__PRICE_FORMAT__HPP
+
+#include <cstdint>
+#include <cstring>
+#include <cstddef>
+#include <string_view>
+
+namespace wbx {
+namespace exc {
+
+static const char fmt_digit_pairs[201] =
+	"00010203040506070809"
+	"10111213141516171819"
+	"20212223242526272829"
+	"30313233343536373839"
+	"40414243444546474849"
+	"50515253545556575859"
+	"60616263646566676869"
+	"70717273747576777879"
+	"80818283848586878889"
+	"90919293949596979899";
+
+// Decimal digits of @v, right-aligned at @end. Returns the first one.
+static inline char *fmtU64Rev(char *end, uint64_t v) noexcept
+{
+	while (v >= 100) {
+		end -= 2;
+		memcpy(end, &fmt_digit_pairs[(v % 100) * 2], 2);
+		v /= 100;
+	}
+
+	if (v >= 10) {
+		end -= 2;
+		memcpy(end, &fmt_digit_pairs[v * 2], 2);
+	} else {
+		*--end = (char)('0' + v);
+	}
+
+	return end;
+}
+
+/*
+ * Write @value / 10^@scale with exactly @scale decimals into @buf,
+ * NUL-terminated. Returns the length without the NUL, or 0 if @size
+ * is too small. 24 + @scale bytes are always enough.
+ */
+static inline size_t fmtFixed(char *buf, size_t size, uint64_t value,
+			      uint32_t scale) noexcept
+{
+	char tmp[20];
+	char *digits;
+	size_t len, ret, nr_int;
+
+	digits = fmtU64Rev(tmp + sizeof(tmp), value);
+	len = (size_t)(tmp + sizeof(tmp) - digits);
+
+	if (!scale) {
+		if (len >= size)
+			return 0;
+		memcpy(buf, digits, len);
+		buf[len] = '\0';
+		return len;
+	}
+
+	if (scale >= len) {
+		ret = (size_t)scale + 2;
+		if (ret >= size)
+			return 0;
+		buf[0] = '0';
+		buf[1] = '.';
+		memset(buf + 2, '0', scale - len);
+		memcpy(buf + ret - len, digits, len);
+	} else {
+		ret = len + 1;
+		if (ret >= size)
+			return 0;
+		nr_int = len - scale;
+		memcpy(buf, digits, nr_int);
+		buf[nr_int] = '.';
+		memcpy(buf + nr_int + 1, digits + nr_int, scale);
+	}
+
+	buf[ret] = '\0';
+	return ret;
+}
+
+/*
+ * fmtFixed() for @n values of the same scale, stored back to back in
+ * @buf. @out[i] points at the i-th NUL-terminated string. Returns the
+ * bytes used, or 0 if @size is too small.
+ */
+static inline size_t fmtFixedBulk(char *buf, size_t size, const uint64_t *values,
+				  size_t n, uint32_t scale, const char **out) noexcept
+{
+	size_t i, len, used = 0;
+
+	for (i = 0; i < n; i++) {
+		len = fmtFixed(buf + used, size - used, values[i], scale);
+		if (!len)
+			return 0;
+
+		out[i] = buf + used;
+		used += len + 1;
+	}
+
+	return used;
+}
+
+/*
+ * Parse a non-negative decimal like "123.450" into @value = 123450 and
+ * @scale = 3. False on anything else, or more than 19 significant
+ * digits. Leading zeros do not count: fmtFixed() of a 19 digit value
+ * parses back at any scale.
+ */
+static inline bool parseFixed(std::string_view s, uint64_t *value,
+			      uint32_t *scale) noexcept
+{
+	uint64_t v = 0;
+	uint32_t nr_digits = 0, nr_sig = 0, sc = 0;
+	bool dot = false;
+	size_t i;
+
+	for (i = 0; i < s.size(); i++) {
+		char c = s[i];
+
+		if (c == '.' && !dot) {
+			dot = true;
+			continue;
+		}
+
+		if (c < '0' || c > '9')
+			return false;
+		if ((v || c != '0') && ++nr_sig > 19)
+			return false;
+
+		nr_digits++;
+		v = v * 10 + (uint64_t)(c - '0');
+		sc += dot;
+	}
+
+	if (!nr_digits)
+		return false;
+
+	*value = v;
+	*scale = sc;
+	return true;
+}
+
+} /* namespace exc */
+} /* namespace wbx */
+
+#endif /* #ifndef EXC__PRICE_FORMAT__HPP */
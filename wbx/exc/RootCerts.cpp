@@ -2,16 +2,22 @@
 
 #include <wbx/exc/RootCerts.hpp>
 #include <boost/asio/ssl.hpp>
+#include <openssl/err.h>
+#include <openssl/pem.h>
+#include <openssl/x509.h>
+#include <algorithm>
+#include <chrono>
+#include <cstring>
 #include <string>
+#include <mutex>
+#include <map>
 
 namespace ssl = boost::asio::ssl; // from <boost/asio/ssl.hpp>
+using wbx::exc::WsTrustStore;
 
 namespace detail {
 
-static void
-load_root_certificates(ssl::context& ctx, boost::system::error_code& ec)
-{
-	std::string cert =
+static const char root_certs_pem[] =
 		"# ACCVRAIZ1\n"
 		"-----BEGIN CERTIFICATE-----\n"
 		"MIIH0zCCBbugAwIBAgIIXsO3pkN/pOAwDQYJKoZIhvcNAQEFBQAwQjESMBAGA1UE\n"
@@ -57,8 +63,7 @@ load_root_certificates(ssl::context& ctx, boost::system::error_code& ec)
 		"d3+YJ5oyXSrjhO7FmGYvliAd3djDJ9ew+f7Zfc3Qn48LFFhRny+Lwzgt3uiP1o2H\n"
 		"pPVWQxaZLPSkVrQ0uGE3ycJYgBugl6H8WY3pEfbRD0tVNEYqi4Y7\n"
 		"-----END CERTIFICATE-----\n"
-		"\n";
-	cert +=
+		"\n"
 		"# AC RAIZ FNMT-RCM\n"
 		"-----BEGIN CERTIFICATE-----\n"
 		"MIIFgzCCA2ugAwIBAgIPXZONMGc2yAYdGsdUhGkHMA0GCSqGSIb3DQEBCwUAMDsx\n"
@@ -92,8 +97,7 @@ load_root_certificates(ssl::context& ctx, boost::system::error_code& ec)
 		"RqEIr9baRRmW1FMdW4R58MD3R++Lj8UGrp1MYp3/RgT408m2ECVAdf4WqslKYIYv\n"
 		"uu8wd+RU4riEmViAqhOLUTpPSPaLtrM=\n"
 		"-----END CERTIFICATE-----\n"
-		"\n";
-	cert +=
+		"\n"
 		"# Actalis Authentication Root CA\n"
 		"-----BEGIN CERTIFICATE-----\n"
 		"MIIFuzCCA6OgAwIBAgIIVwoRl0LE48wwDQYJKoZIhvcNAQELBQAwazELMAkGA1UE\n"
@@ -128,8 +132,7 @@ load_root_certificates(ssl::context& ctx, boost::system::error_code& ec)
 		"LysRJyU3eExRarDzzFhdFPFqSBX/wge2sY0PjlxQRrM9vwGYT7JZVEc+NHt4bVaT\n"
 		"LnPqZih4zR0Uv6CPLy64Lo7yFIrM6bV8+2ydDKXhlg==\n"
 		"-----END CERTIFICATE-----\n"
-		"\n";
-	cert +=
+		"\n"
 		"# AffirmTrust Commercial\n"
 		"-----BEGIN CERTIFICATE-----\n"
 		"MIIDTDCCAjSgAwIBAgIId3cGJyapsXwwDQYJKoZIhvcNAQELBQAwRDELMAkGA1UE\n"
@@ -151,8 +154,7 @@ load_root_certificates(ssl::context& ctx, boost::system::error_code& ec)
 		"N53Tym1+NH4Nn3J2ixufcv1SNUFFApYvHLKac0khsUlHRUe072o0EclNmsxZt9YC\n"
 		"nlpOZbWUrhvfKbAW8b8Angc6F2S1BLUjIZkKlTuXfO8=\n"
 		"-----END CERTIFICATE-----\n"
-		"\n";
-	cert +=
+		"\n"
 		"# AffirmTrust Networking\n"
 		"-----BEGIN CERTIFICATE-----\n"
 		"MIIDTDCCAjSgAwIBAgIIfE8EORzUmS0wDQYJKoZIhvcNAQEFBQAwRDELMAkGA1UE\n"
@@ -174,8 +176,7 @@ load_root_certificates(ssl::context& ctx, boost::system::error_code& ec)
 		"olu9rxj5kFDNcFn4J2dHy8egBzp90SxdbBk6ZrV9/ZFvgrG+CJPbFEfxojfHRZ48\n"
 		"x3evZKiT3/Zpg4Jg8klCNO1aAFSFHBY2kgxc+qatv9s=\n"
 		"-----END CERTIFICATE-----\n"
-		"\n";
-	cert +=
+		"\n"
 		"# AffirmTrust Premium\n"
 		"-----BEGIN CERTIFICATE-----\n"
 		"MIIFRjCCAy6gAwIBAgIIbYwURrGmCu4wDQYJKoZIhvcNAQEMBQAwQTELMAkGA1UE\n"
@@ -208,8 +209,7 @@ load_root_certificates(ssl::context& ctx, boost::system::error_code& ec)
 		"RtGdFNrHF+QFlozEJLUbzxQHskD4o55BhrwE0GuWyCqANP2/7waj3VjFhT0+j/6e\n"
 		"KeC2uAloGRwYQw==\n"
 		"-----END CERTIFICATE-----\n"
-		"\n";
-	cert +=
+		"\n"
 		"# AffirmTrust Premium ECC\n"
 		"-----BEGIN CERTIFICATE-----\n"
 		"MIIB/jCCAYWgAwIBAgIIdJclisc/elQwCgYIKoZIzj0EAwMwRTELMAkGA1UEBhMC\n"
@@ -224,8 +224,7 @@ load_root_certificates(ssl::context& ctx, boost::system::error_code& ec)
 		"aobgxCd05DhT1wV/GzTjxi+zygk8N53X57hG8f2h4nECMEJZh0PUUd+60wkyWs6I\n"
 		"flc9nF9Ca/UHLbXwgpP5WW+uZPpY5Yse42O+tYHNbwKMeQ==\n"
 		"-----END CERTIFICATE-----\n"
-		"\n";
-	cert +=
+		"\n"
 		"# Amazon Root CA 1\n"
 		"-----BEGIN CERTIFICATE-----\n"
 		"MIIDQTCCAimgAwIBAgITBmyfz5m/jAo54vB4ikPmljZbyjANBgkqhkiG9w0BAQsF\n"
@@ -247,8 +246,7 @@ load_root_certificates(ssl::context& ctx, boost::system::error_code& ec)
 		"5MsI+yMRQ+hDKXJioaldXgjUkK642M4UwtBV8ob2xJNDd2ZhwLnoQdeXeGADbkpy\n"
 		"rqXRfboQnoZsG4q5WTP468SQvvG5\n"
 		"-----END CERTIFICATE-----\n"
-		"\n";
-	cert +=
+		"\n"
 		"# Amazon Root CA 2\n"
 		"-----BEGIN CERTIFICATE-----\n"
 		"MIIFQTCCAymgAwIBAgITBmyf0pY1hp8KD+WGePhbJruKNzANBgkqhkiG9w0BAQwF\n"
@@ -281,8 +279,7 @@ load_root_certificates(ssl::context& ctx, boost::system::error_code& ec)
 		"9jVlpNMKVv/1F2Rs76giJUmTtt8AF9pYfl3uxRuw0dFfIRDH+fO6AgonB8Xx1sfT\n"
 		"4PsJYGw=\n"
 		"-----END CERTIFICATE-----\n"
-		"\n";
-	cert +=
+		"\n"
 		"# Amazon Root CA 3\n"
 		"-----BEGIN CERTIFICATE-----\n"
 		"MIIBtjCCAVugAwIBAgITBmyf1XSXNmY/Owua2eiedgPySjAKBggqhkjOPQQDAjA5\n"
@@ -296,8 +293,7 @@ load_root_certificates(ssl::context& ctx, boost::system::error_code& ec)
 		"BqWTrBqYaGFy+uGh0PsceGCmQ5nFuMQCIQCcAu/xlJyzlvnrxir4tiz+OpAUFteM\n"
 		"YyRIHN8wfdVoOw==\n"
 		"-----END CERTIFICATE-----\n"
-		"\n";
-	cert +=
+		"\n"
 		"# Amazon Root CA 4\n"
 		"-----BEGIN CERTIFICATE-----\n"
 		"MIIB8jCCAXigAwIBAgITBmyf18G7EEwpQ+Vxe3ssyBrBDjAKBggqhkjOPQQDAzA5\n"
@@ -312,8 +308,7 @@ load_root_certificates(ssl::context& ctx, boost::system::error_code& ec)
 		"CkcO8DdZEv8tmZQoTipPNU0zWgIxAOp1AE47xDqUEpHJWEadIRNyp4iciuRMStuW\n"
 		"1KyLa2tJElMzrdfkviT8tQp21KW8EA==\n"
 		"-----END CERTIFICATE-----\n"
-		"\n";
-	cert +=
+		"\n"
 		"# Atos TrustedRoot 2011\n"
 		"-----BEGIN CERTIFICATE-----\n"
 		"MIIDdzCCAl+gAwIBAgIIXDPLYixfszIwDQYJKoZIhvcNAQELBQAwPDEeMBwGA1UE\n"
@@ -336,8 +331,7 @@ load_root_certificates(ssl::context& ctx, boost::system::error_code& ec)
 		"lmh6cYGJ4Qvh6hEbaAjMaZ7snkGeRDImeuKHCnE96+RapNLbxc3G3mB/ufNPRJLv\n"
 		"KrcYPqcZ2Qt9sTdBQrC6YB3y/gkRsPCHe6ed\n"
 		"-----END CERTIFICATE-----\n"
-		"\n";
-	cert +=
+		"\n"
 		"# Autoridad de Certificacion Firmaprofesional CIF A62634068\n"
 		"-----BEGIN CERTIFICATE-----\n"
 		"MIIGFDCCA/ygAwIBAgIIU+w77vuySF8wDQYJKoZIhvcNAQEFBQAwUTELMAkGA1UE\n"
@@ -374,8 +368,7 @@ load_root_certificates(ssl::context& ctx, boost::system::error_code& ec)
 		"Q0CgFzzr6juwcqajuUpLXhZI9LK8yIySxZ2frHI2vDSANGupi5LAuBft7HZT9SQB\n"
 		"jLMi6Et8Vcad+qMUu2WFbm5PEn4KPJ2V\n"
 		"-----END CERTIFICATE-----\n"
-		"\n";
-	cert +=
+		"\n"
 		"# Baltimore CyberTrust Root\n"
 		"-----BEGIN CERTIFICATE-----\n"
 		"MIIDdzCCAl+gAwIBAgIEAgAAuTANBgkqhkiG9w0BAQUFADBaMQswCQYDVQQGEwJJ\n"
@@ -398,8 +391,7 @@ load_root_certificates(ssl::context& ctx, boost::system::error_code& ec)
 		"ksLi4xaNmjICq44Y3ekQEe5+NauQrz4wlHrQMz2nZQ/1/I6eYs9HRCwBXbsdtTLS\n"
 		"R9I4LtD+gdwyah617jzV/OeBHRnDJELqYzmp\n"
 		"-----END CERTIFICATE-----\n"
-		"\n";
-	cert +=
+		"\n"
 		"# Buypass Class 2 Root CA\n"
 		"-----BEGIN CERTIFICATE-----\n"
 		"MIIFWTCCA0GgAwIBAgIBAjANBgkqhkiG9w0BAQsFADBOMQswCQYDVQQGEwJOTzEd\n"
@@ -432,8 +424,7 @@ load_root_certificates(ssl::context& ctx, boost::system::error_code& ec)
 		"3PFaTWwyI0PurKju7koSCTxdccK+efrCh2gdC/1cacwG0Jp9VJkqyTkaGa9LKkPz\n"
 		"Y11aWOIv4x3kqdbQCtCev9eBCfHJxyYNrJgWVqA=\n"
 		"-----END CERTIFICATE-----\n"
-		"\n";
-	cert +=
+		"\n"
 		"# Buypass Class 3 Root CA\n"
 		"-----BEGIN CERTIFICATE-----\n"
 		"MIIFWTCCA0GgAwIBAgIBAjANBgkqhkiG9w0BAQsFADBOMQswCQYDVQQGEwJOTzEd\n"
@@ -466,8 +457,7 @@ load_root_certificates(ssl::context& ctx, boost::system::error_code& ec)
 		"u79leNKGef9JOxqDDPDeeOzI8k1MGt6CKfjBWtrt7uYnXuhF0J0cUahoq0Tj0Itq\n"
 		"4/g7u9xN12TyUb7mqqta6THuBrxzvxNiCp/HuZc=\n"
 		"-----END CERTIFICATE-----\n"
-		"\n";
-	cert +=
+		"\n"
 		"# CA Disig Root R2\n"
 		"-----BEGIN CERTIFICATE-----\n"
 		"MIIFaTCCA1GgAwIBAgIJAJK4iNuwisFjMA0GCSqGSIb3DQEBCwUAMFIxCzAJBgNV\n"
@@ -500,8 +490,7 @@ load_root_certificates(ssl::context& ctx, boost::system::error_code& ec)
 		"zMOl6W8KjptlwlCFtaOgUxLMVYdh84GuEEZhvUQhuMI9dM9+JDX6HAcOmz0iyu8x\n"
 		"L4ysEr3vQCj8KWefshNPZiTEUxnpHikV7+ZtsH8tZ/3zbBt1RqPlShfppNcL\n"
 		"-----END CERTIFICATE-----\n"
-		"\n";
-	cert +=
+		"\n"
 		"# CFCA EV ROOT\n"
 		"-----BEGIN CERTIFICATE-----\n"
 		"MIIFjTCCA3WgAwIBAgIEGErM1jANBgkqhkiG9w0BAQsFADBWMQswCQYDVQQGEwJD\n"
@@ -535,8 +524,7 @@ load_root_certificates(ssl::context& ctx, boost::system::error_code& ec)
 		"AAoACxGV2lZFA4gKn2fQ1XmxqI1AbQ3CekD6819kR5LLU7m7Wc5P/dAVUwHY3+vZ\n"
 		"5nbv0CO7O6l5s9UCKc2Jo5YPSjXnTkLAdc0Hz+Ys63su\n"
 		"-----END CERTIFICATE-----\n"
-		"\n";
-	cert +=
+		"\n"
 		"# COMODO Certification Authority\n"
 		"-----BEGIN CERTIFICATE-----\n"
 		"MIIEHTCCAwWgAwIBAgIQToEtioJl4AsC7j41AkblPTANBgkqhkiG9w0BAQUFADCB\n"
@@ -563,8 +551,7 @@ load_root_certificates(ssl::context& ctx, boost::system::error_code& ec)
 		"BA6+C4OmF4O5MBKgxTMVBbkN+8cFduPYSo38NBejxiEovjBFMR7HeL5YYTisO+IB\n"
 		"ZQ==\n"
 		"-----END CERTIFICATE-----\n"
-		"\n";
-	cert +=
+		"\n"
 		"# COMODO ECC Certification Authority\n"
 		"-----BEGIN CERTIFICATE-----\n"
 		"MIICiTCCAg+gAwIBAgIQH0evqmIAcFBUTAGem2OZKjAKBggqhkjOPQQDAzCBhTEL\n"
@@ -582,8 +569,7 @@ load_root_certificates(ssl::context& ctx, boost::system::error_code& ec)
 		"fQjGGoe9GKhzvSbKYAydzpmfz1wPMOG+FDHqAjAU9JM8SaczepBGR7NjfRObTrdv\n"
 		"GDeAU/7dIOA1mjbRxwG55tzd8/8dLDoWV9mSOdY=\n"
 		"-----END CERTIFICATE-----\n"
-		"\n";
-	cert +=
+		"\n"
 		"# COMODO RSA Certification Authority\n"
 		"-----BEGIN CERTIFICATE-----\n"
 		"MIIF2DCCA8CgAwIBAgIQTKr5yttjb+Af907YWwOGnTANBgkqhkiG9w0BAQwFADCB\n"
@@ -619,8 +605,7 @@ load_root_certificates(ssl::context& ctx, boost::system::error_code& ec)
 		"0MC2Hb46TpSi125sC8KKfPog88Tk5c0NqMuRkrF8hey1FGlmDoLnzc7ILaZRfyHB\n"
 		"NVOFBkpdn627G190\n"
 		"-----END CERTIFICATE-----\n"
-		"\n";
-	cert +=
+		"\n"
 		"# Certigna\n"
 		"-----BEGIN CERTIFICATE-----\n"
 		"MIIDqDCCApCgAwIBAgIJAP7c4wEPyUj/MA0GCSqGSIb3DQEBBQUAMDQxCzAJBgNV\n"
@@ -644,8 +629,7 @@ load_root_certificates(ssl::context& ctx, boost::system::error_code& ec)
 		"t0QmwCbAr1UwnjvVNioZBPRcHv/PLLf/0P2HQBHVESO7SMAhqaQoLf0V+LBOK/Qw\n"
 		"WyH8EZE0vkHve52Xdf+XlcCWWC/qu0bXu+TZLg==\n"
 		"-----END CERTIFICATE-----\n"
-		"\n";
-	cert +=
+		"\n"
 		"# Certigna Root CA\n"
 		"-----BEGIN CERTIFICATE-----\n"
 		"MIIGWzCCBEOgAwIBAgIRAMrpG4nxVQMNo+ZBbcTjpuEwDQYJKoZIhvcNAQELBQAw\n"
@@ -683,8 +667,7 @@ load_root_certificates(ssl::context& ctx, boost::system::error_code& ec)
 		"jWZSaX5LaAzHHjcng6WMxwLkFM1JAbBzs/3GkDpv0mztO+7skb6iQ12LAEpmJURw\n"
 		"3kAP+HwV96LOPNdeE4yBFxgX0b3xdxA61GU5wSesVywlVP+i2k+KYTlerj1KjL0=\n"
 		"-----END CERTIFICATE-----\n"
-		"\n";
-	cert +=
+		"\n"
 		"# Certum Trusted Network CA\n"
 		"-----BEGIN CERTIFICATE-----\n"
 		"MIIDuzCCAqOgAwIBAgIDBETAMA0GCSqGSIb3DQEBBQUAMH4xCzAJBgNVBAYTAlBM\n"
@@ -708,8 +691,7 @@ load_root_certificates(ssl::context& ctx, boost::system::error_code& ec)
 		"VoNzcOSGGtIxQbovvi0TWnZvTuhOgQ4/WwMioBK+ZlgRSssDxLQqKi2WF+A5VLxI\n"
 		"03YnnZotBqbJ7DnSq9ufmgsnAjUpsUCV5/nonFWIGUbWtzT1fs45mtk48VH3Tyw=\n"
 		"-----END CERTIFICATE-----\n"
-		"\n";
-	cert +=
+		"\n"
 		"# Certum Trusted Network CA 2\n"
 		"-----BEGIN CERTIFICATE-----\n"
 		"MIIF0jCCA7qgAwIBAgIQIdbQSk8lD8kyN/yqXhKN6TANBgkqhkiG9w0BAQ0FADCB\n"
@@ -745,8 +727,7 @@ load_root_certificates(ssl::context& ctx, boost::system::error_code& ec)
 		"5O4/E2Hu29othfDNrp2yGAlFw5Khchf8R7agCyzxxN5DaAhqXzvwdmP7zAYspsbi\n"
 		"DrW5viSP\n"
 		"-----END CERTIFICATE-----\n"
-		"\n";
-	cert +=
+		"\n"
 		"# Chambers of Commerce Root - 2008\n"
 		"-----BEGIN CERTIFICATE-----\n"
 		"MIIHTzCCBTegAwIBAgIJAKPaQn6ksa7aMA0GCSqGSIb3DQEBBQUAMIGuMQswCQYD\n"
@@ -790,8 +771,7 @@ load_root_certificates(ssl::context& ctx, boost::system::error_code& ec)
 		"OGcEMeyP84LG3rlV8zsxkVrctQgVrXYlCg17LofiDKYGvCYQbTed7N14jHyAxfDZ\n"
 		"d0jQ\n"
 		"-----END CERTIFICATE-----\n"
-		"\n";
-	cert +=
+		"\n"
 		"# Comodo AAA Services root\n"
 		"-----BEGIN CERTIFICATE-----\n"
 		"MIIEMjCCAxqgAwIBAgIBATANBgkqhkiG9w0BAQUFADB7MQswCQYDVQQGEwJHQjEb\n"
@@ -818,8 +798,7 @@ load_root_certificates(ssl::context& ctx, boost::system::error_code& ec)
 		"l2D4kF501KKaU73yqWjgom7C12yxow+ev+to51byrvLjKzg6CYG1a4XXvi3tPxq3\n"
 		"smPi9WIsgtRqAEFQ8TmDn5XpNpaYbg==\n"
 		"-----END CERTIFICATE-----\n"
-		"\n";
-	cert +=
+		"\n"
 		"# Cybertrust Global Root\n"
 		"-----BEGIN CERTIFICATE-----\n"
 		"MIIDoTCCAomgAwIBAgILBAAAAAABD4WqLUgwDQYJKoZIhvcNAQEFBQAwOzEYMBYG\n"
@@ -843,8 +822,7 @@ load_root_certificates(ssl::context& ctx, boost::system::error_code& ec)
 		"A06dGiBh+4E37F78CkWr1+cXVdCg6mCbpvbjjFspwgZgFJ0tl0ypkxWdYcQBX0jW\n"
 		"WL1WMRJOEcgh4LMRkWXbtKaIOM5V\n"
 		"-----END CERTIFICATE-----\n"
-		"\n";
-	cert +=
+		"\n"
 		"# D-TRUST Root Class 3 CA 2 2009\n"
 		"-----BEGIN CERTIFICATE-----\n"
 		"MIIEMzCCAxugAwIBAgIDCYPzMA0GCSqGSIb3DQEBCwUAME0xCzAJBgNVBAYTAkRF\n"
@@ -871,8 +849,7 @@ load_root_certificates(ssl::context& ctx, boost::system::error_code& ec)
 		"PIWmawomDeCTmGCufsYkl4phX5GOZpIJhzbNi5stPvZR1FDUWSi9g/LMKHtThm3Y\n"
 		"Johw1+qRzT65ysCQblrGXnRl11z+o+I=\n"
 		"-----END CERTIFICATE-----\n"
-		"\n";
-	cert +=
+		"\n"
 		"# D-TRUST Root Class 3 CA 2 EV 2009\n"
 		"-----BEGIN CERTIFICATE-----\n"
 		"MIIEQzCCAyugAwIBAgIDCYP0MA0GCSqGSIb3DQEBCwUAMFAxCzAJBgNVBAYTAkRF\n"
@@ -899,8 +876,7 @@ load_root_certificates(ssl::context& ctx, boost::system::error_code& ec)
 		"xpeG0ILD5EJt/rDiZE4OJudANCa1CInXCGNjOCd1HjPqbqjdn5lPdE2BiYBL3ZqX\n"
 		"KVwvvoFBuYz/6n1gBp7N1z3TLqMVvKjmJuVvw9y4AyHqnxbxLFS1\n"
 		"-----END CERTIFICATE-----\n"
-		"\n";
-	cert +=
+		"\n"
 		"# DST Root CA X3\n"
 		"-----BEGIN CERTIFICATE-----\n"
 		"MIIDSjCCAjKgAwIBAgIQRK+wgNajJ7qJMDmGLvhAazANBgkqhkiG9w0BAQUFADA/\n"
@@ -922,8 +898,7 @@ load_root_certificates(ssl::context& ctx, boost::system::error_code& ec)
 		"JDGFoqgCWjBH4d1QB7wCCZAA62RjYJsWvIjJEubSfZGL+T0yjWW06XyxV3bqxbYo\n"
 		"Ob8VZRzI9neWagqNdwvYkQsEjgfbKbYK7p2CNTUQ\n"
 		"-----END CERTIFICATE-----\n"
-		"\n";
-	cert +=
+		"\n"
 		"# DigiCert Assured ID Root CA\n"
 		"-----BEGIN CERTIFICATE-----\n"
 		"MIIDtzCCAp+gAwIBAgIQDOfg5RfYRv6P5WD8G/AwOTANBgkqhkiG9w0BAQUFADBl\n"
@@ -947,8 +922,7 @@ load_root_certificates(ssl::context& ctx, boost::system::error_code& ec)
 		"H2sMNgcWfzd8qVttevESRmCD1ycEvkvOl77DZypoEd+A5wwzZr8TDRRu838fYxAe\n"
 		"+o0bJW1sj6W3YQGx0qMmoRBxna3iw/nDmVG3KwcIzi7mULKn+gpFL6Lw8g==\n"
 		"-----END CERTIFICATE-----\n"
-		"\n";
-	cert +=
+		"\n"
 		"# DigiCert Assured ID Root G2\n"
 		"-----BEGIN CERTIFICATE-----\n"
 		"MIIDljCCAn6gAwIBAgIQC5McOtY5Z+pnI7/Dr5r0SzANBgkqhkiG9w0BAQsFADBl\n"
@@ -972,8 +946,7 @@ load_root_certificates(ssl::context& ctx, boost::system::error_code& ec)
 		"ON9vvKO+KSAnq3T/EyJ43pdSVR6DtVQgA+6uwE9W3jfMw3+qBCe703e4YtsXfJwo\n"
 		"IhNzbM8m9Yop5w==\n"
 		"-----END CERTIFICATE-----\n"
-		"\n";
-	cert +=
+		"\n"
 		"# DigiCert Assured ID Root G3\n"
 		"-----BEGIN CERTIFICATE-----\n"
 		"MIICRjCCAc2gAwIBAgIQC6Fa+h3foLVJRK/NJKBs7DAKBggqhkjOPQQDAzBlMQsw\n"
@@ -990,8 +963,7 @@ load_root_certificates(ssl::context& ctx, boost::system::error_code& ec)
 		"JjZ91eQ0hjkCMHw2U/Aw5WJjOpnitqM7mzT6HtoQknFekROn3aRukswy1vUhZscv\n"
 		"6pZjamVFkpUBtA==\n"
 		"-----END CERTIFICATE-----\n"
-		"\n";
-	cert +=
+		"\n"
 		"# DigiCert Global Root CA\n"
 		"-----BEGIN CERTIFICATE-----\n"
 		"MIIDrzCCApegAwIBAgIQCDvgVpBCRrGhdWrJWZHHSjANBgkqhkiG9w0BAQUFADBh\n"
@@ -1015,8 +987,7 @@ load_root_certificates(ssl::context& ctx, boost::system::error_code& ec)
 		"YSEY1QSteDwsOoBrp+uvFRTp2InBuThs4pFsiv9kuXclVzDAGySj4dzp30d8tbQk\n"
 		"CAUw7C29C79Fv1C5qfPrmAESrciIxpg0X40KPMbp1ZWVbd4=\n"
 		"-----END CERTIFICATE-----\n"
-		"\n";
-	cert +=
+		"\n"
 		"# DigiCert Global Root G2\n"
 		"-----BEGIN CERTIFICATE-----\n"
 		"MIIDjjCCAnagAwIBAgIQAzrx5qcRqaC7KGSxHQn65TANBgkqhkiG9w0BAQsFADBh\n"
@@ -1040,8 +1011,7 @@ load_root_certificates(ssl::context& ctx, boost::system::error_code& ec)
 		"pLiaWN0bfVKfjllDiIGknibVb63dDcY3fe0Dkhvld1927jyNxF1WW6LZZm6zNTfl\n"
 		"MrY=\n"
 		"-----END CERTIFICATE-----\n"
-		"\n";
-	cert +=
+		"\n"
 		"# DigiCert Global Root G3\n"
 		"-----BEGIN CERTIFICATE-----\n"
 		"MIICPzCCAcWgAwIBAgIQBVVWvPJepDU1w6QP1atFcjAKBggqhkjOPQQDAzBhMQsw\n"
@@ -1058,8 +1028,7 @@ load_root_certificates(ssl::context& ctx, boost::system::error_code& ec)
 		"oAIwOWZbwmSNuJ5Q3KjVSaLtx9zRSX8XAbjIho9OjIgrqJqpisXRAL34VOKa5Vt8\n"
 		"sycX\n"
 		"-----END CERTIFICATE-----\n"
-		"\n";
-	cert +=
+		"\n"
 		"# DigiCert High Assurance EV Root CA\n"
 		"-----BEGIN CERTIFICATE-----\n"
 		"MIIDxTCCAq2gAwIBAgIQAqxcJmoLQJuPC3nyrkYldzANBgkqhkiG9w0BAQUFADBs\n"
@@ -1084,8 +1053,7 @@ load_root_certificates(ssl::context& ctx, boost::system::error_code& ec)
 		"vEsXCS+0yx5DaMkHJ8HSXPfqIbloEpw8nL+e/IBcm2PN7EeqJSdnoDfzAIJ9VNep\n"
 		"+OkuE6N36B9K\n"
 		"-----END CERTIFICATE-----\n"
-		"\n";
-	cert +=
+		"\n"
 		"# DigiCert Trusted Root G4\n"
 		"-----BEGIN CERTIFICATE-----\n"
 		"MIIFkDCCA3igAwIBAgIQBZsbV56OITLiOQe9p3d1XDANBgkqhkiG9w0BAQwFADBi\n"
@@ -1119,8 +1087,7 @@ load_root_certificates(ssl::context& ctx, boost::system::error_code& ec)
 		"/YldvIViHTLSoCtU7ZpXwdv6EM8Zt4tKG48BtieVU+i2iW1bvGjUI+iLUaJW+fCm\n"
 		"gKDWHrO8Dw9TdSmq6hN35N6MgSGtBxBHEa2HPQfRdbzP82Z+\n"
 		"-----END CERTIFICATE-----\n"
-		"\n";
-	cert +=
+		"\n"
 		"# E-Tugra Certification Authority\n"
 		"-----BEGIN CERTIFICATE-----\n"
 		"MIIGSzCCBDOgAwIBAgIIamg+nFGby1MwDQYJKoZIhvcNAQELBQAwgbIxCzAJBgNV\n"
@@ -1158,8 +1125,7 @@ load_root_certificates(ssl::context& ctx, boost::system::error_code& ec)
 		"y4Q08ijE6m30Ku/Ba3ba+367hTzSU8JNvnHhRdH9I2cNE3X7z2VnIp2usAnRCf8d\n"
 		"NL/+I5c30jn6PQ0GC7TbO6Orb1wdtn7os4I07QZcJA==\n"
 		"-----END CERTIFICATE-----\n"
-		"\n";
-	cert +=
+		"\n"
 		"# EC-ACC\n"
 		"-----BEGIN CERTIFICATE-----\n"
 		"MIIFVjCCBD6gAwIBAgIQ7is969Qh3hSoYqwE893EATANBgkqhkiG9w0BAQUFADCB\n"
@@ -1192,8 +1158,7 @@ load_root_certificates(ssl::context& ctx, boost::system::error_code& ec)
 		"Agu+TGbrIP65y7WZf+a2E/rKS03Z7lNGBjvGTq2TWoF+bCpLagVFjPIhpDGQh2xl\n"
 		"nJ2lYJU6Un/10asIbvPuW/mIPX64b24D5EI=\n"
 		"-----END CERTIFICATE-----\n"
-		"\n";
-	cert +=
+		"\n"
 		"# EE Certification Centre Root CA\n"
 		"-----BEGIN CERTIFICATE-----\n"
 		"MIIEAzCCAuugAwIBAgIQVID5oHPtPwBMyonY43HmSjANBgkqhkiG9w0BAQUFADB1\n"
@@ -1219,8 +1184,7 @@ load_root_certificates(ssl::context& ctx, boost::system::error_code& ec)
 		"iAYLtqZLICjU3j2LrTcFU3T+bsy8QxdxXvnFzBqpYe73dgzzcvRyrc9yAjYHR8/v\n"
 		"GVCJYMzpJJUPwssd8m92kMfMdcGWxZ0=\n"
 		"-----END CERTIFICATE-----\n"
-		"\n";
-	cert +=
+		"\n"
 		"# Entrust.net Premium 2048 Secure Server CA\n"
 		"-----BEGIN CERTIFICATE-----\n"
 		"MIIEKjCCAxKgAwIBAgIEOGPe+DANBgkqhkiG9w0BAQUFADCBtDEUMBIGA1UEChML\n"
@@ -1247,8 +1211,7 @@ load_root_certificates(ssl::context& ctx, boost::system::error_code& ec)
 		"bYQLCIt+jerXmCHG8+c8eS9enNFMFY3h7CI3zJpDC5fcgJCNs2ebb0gIFVbPv/Er\n"
 		"fF6adulZkMV8gzURZVE=\n"
 		"-----END CERTIFICATE-----\n"
-		"\n";
-	cert +=
+		"\n"
 		"# Entrust Root Certification Authority\n"
 		"-----BEGIN CERTIFICATE-----\n"
 		"MIIEkTCCA3mgAwIBAgIERWtQVDANBgkqhkiG9w0BAQUFADCBsDELMAkGA1UEBhMC\n"
@@ -1277,8 +1240,7 @@ load_root_certificates(ssl::context& ctx, boost::system::error_code& ec)
 		"eu6FSqdQgPCnXEqULl8FmTxSQeDNtGPPAUO6nIPcj2A781q0tHuu2guQOHXvgR1m\n"
 		"0vdXcDazv/wor3ElhVsT/h5/WrQ8\n"
 		"-----END CERTIFICATE-----\n"
-		"\n";
-	cert +=
+		"\n"
 		"# Entrust Root Certification Authority - EC1\n"
 		"-----BEGIN CERTIFICATE-----\n"
 		"MIIC+TCCAoCgAwIBAgINAKaLeSkAAAAAUNCR+TAKBggqhkjOPQQDAzCBvzELMAkG\n"
@@ -1298,8 +1260,7 @@ load_root_certificates(ssl::context& ctx, boost::system::error_code& ec)
 		"R98crlOZF7ZvHH3hvxGU0QOIdeSNiaSKd0bebWHvAvX7td/M/k7//qnmpwIwW5nX\n"
 		"hTcGtXsI/esni0qU+eH6p44mCOh8kmhtc9hvJqwhAriZtyZBWyVgrtBIGu4G\n"
 		"-----END CERTIFICATE-----\n"
-		"\n";
-	cert +=
+		"\n"
 		"# Entrust Root Certification Authority - G2\n"
 		"-----BEGIN CERTIFICATE-----\n"
 		"MIIEPjCCAyagAwIBAgIESlOMKDANBgkqhkiG9w0BAQsFADCBvjELMAkGA1UEBhMC\n"
@@ -1326,8 +1287,7 @@ load_root_certificates(ssl::context& ctx, boost::system::error_code& ec)
 		"nAuknZoh8/CbCzB428Hch0P+vGOaysXCHMnHjf87ElgI5rY97HosTvuDls4MPGmH\n"
 		"VHOkc8KT/1EQrBVUAdj8BbGJoX90g5pJ19xOe4pIb4tF9g==\n"
 		"-----END CERTIFICATE-----\n"
-		"\n";
-	cert +=
+		"\n"
 		"# Entrust Root Certification Authority - G4\n"
 		"-----BEGIN CERTIFICATE-----\n"
 		"MIIGSzCCBDOgAwIBAgIRANm1Q3+vqTkPAAAAAFVlrVgwDQYJKoZIhvcNAQELBQAw\n"
@@ -1365,8 +1325,7 @@ load_root_certificates(ssl::context& ctx, boost::system::error_code& ec)
 		"5F6G+TaU33fD6Q3AOfF5u0aOq0NZJ7cguyPpVkAh7DE9ZapD8j3fcEThuk0mEDuY\n"
 		"n/PIjhs4ViFqUZPTkcpG2om3PVODLAgfi49T3f+sHw==\n"
 		"-----END CERTIFICATE-----\n"
-		"\n";
-	cert +=
+		"\n"
 		"# GDCA TrustAUTH R5 ROOT\n"
 		"-----BEGIN CERTIFICATE-----\n"
 		"MIIFiDCCA3CgAwIBAgIIfQmX/vBH6nowDQYJKoZIhvcNAQELBQAwYjELMAkGA1UE\n"
@@ -1400,8 +1359,7 @@ load_root_certificates(ssl::context& ctx, boost::system::error_code& ec)
 		"T8p+ck0LcIymSLumoRT2+1hEmRSuqguTaaApJUqlyyvdimYHFngVV3Eb7PVHhPOe\n"
 		"MTd61X8kreS8/f3MboPoDKi3QWwH3b08hpcv0g==\n"
 		"-----END CERTIFICATE-----\n"
-		"\n";
-	cert +=
+		"\n"
 		"# GTS Root R1\n"
 		"-----BEGIN CERTIFICATE-----\n"
 		"MIIFWjCCA0KgAwIBAgIQbkepxUtHDA3sM9CJuRz04TANBgkqhkiG9w0BAQwFADBH\n"
@@ -1434,8 +1392,7 @@ load_root_certificates(ssl::context& ctx, boost::system::error_code& ec)
 		"SQ98POyDGCBDTtWTurQ0sR8WNh8M5mQ5Fkzc4P4dyKliPUDqysU0ArSuiYgzNdws\n"
 		"E3PYJ/HQcu51OyLemGhmW/HGY0dVHLqlCFF1pkgl\n"
 		"-----END CERTIFICATE-----\n"
-		"\n";
-	cert +=
+		"\n"
 		"# GTS Root R2\n"
 		"-----BEGIN CERTIFICATE-----\n"
 		"MIIFWjCCA0KgAwIBAgIQbkepxlqz5yDFMJo/aFLybzANBgkqhkiG9w0BAQwFADBH\n"
@@ -1468,8 +1425,7 @@ load_root_certificates(ssl::context& ctx, boost::system::error_code& ec)
 		"izoHCBy69Y9Vmhh1fuXsgWbRIXOhNUQLgD1bnF5vKheW0YMjiGZt5obicDIvUiLn\n"
 		"yOd/xCxgXS/Dr55FBcOEArf9LAhST4Ldo/DUhgkC\n"
 		"-----END CERTIFICATE-----\n"
-		"\n";
-	cert +=
+		"\n"
 		"# GTS Root R3\n"
 		"-----BEGIN CERTIFICATE-----\n"
 		"MIICDDCCAZGgAwIBAgIQbkepx2ypcyRAiQ8DVd2NHTAKBggqhkjOPQQDAzBHMQsw\n"
@@ -1484,8 +1440,7 @@ load_root_certificates(ssl::context& ctx, boost::system::error_code& ec)
 		"fCPAlaUs3L6JbyO5o91lAFJekazInXJ0glMLfalAvWhgxeG4VDvBNhcl2MG9AjEA\n"
 		"njWSdIUlUfUk7GRSJFClH9voy8l27OyCbvWFGFPouOOaKaqW04MjyaR7YbPMAuhd\n"
 		"-----END CERTIFICATE-----\n"
-		"\n";
-	cert +=
+		"\n"
 		"# GTS Root R4\n"
 		"-----BEGIN CERTIFICATE-----\n"
 		"MIICCjCCAZGgAwIBAgIQbkepyIuUtui7OyrYorLBmTAKBggqhkjOPQQDAzBHMQsw\n"
@@ -1500,8 +1455,7 @@ load_root_certificates(ssl::context& ctx, boost::system::error_code& ec)
 		"CMRw3J5QdCHojXohw0+WbhXRIjVhLfoIN+4Zba3bssx9BzT1YBkstTTZbyACMANx\n"
 		"sbqjYAuG7ZoIapVon+Kz4ZNkfF6Tpt95LY2F45TPI11xzPKwTdb+mciUqXWi4w==\n"
 		"-----END CERTIFICATE-----\n"
-		"\n";
-	cert +=
+		"\n"
 		"# GeoTrust Global CA\n"
 		"-----BEGIN CERTIFICATE-----\n"
 		"MIIDVDCCAjygAwIBAgIDAjRWMA0GCSqGSIb3DQEBBQUAMEIxCzAJBgNVBAYTAlVT\n"
@@ -1523,8 +1477,7 @@ load_root_certificates(ssl::context& ctx, boost::system::error_code& ec)
 		"hw4EbNX/3aBd7YdStysVAq45pmp06drE57xNNB6pXE0zX5IJL4hmXXeXxx12E6nV\n"
 		"5fEWCRE11azbJHFwLJhWC9kXtNHjUStedejV0NxPNO3CBWaAocvmMw==\n"
 		"-----END CERTIFICATE-----\n"
-		"\n";
-	cert +=
+		"\n"
 		"# GeoTrust Primary Certification Authority\n"
 		"-----BEGIN CERTIFICATE-----\n"
 		"MIIDfDCCAmSgAwIBAgIQGKy1av1pthU6Y2yv2vrEoTANBgkqhkiG9w0BAQUFADBY\n"
@@ -1547,8 +1500,7 @@ load_root_certificates(ssl::context& ctx, boost::system::error_code& ec)
 		"UjPtp8nSOQJw+uCxQmYpqptR7TBUIhRf2asdweSU8Pj1K/fqynhG1riR/aYNKxoU\n"
 		"AT6A8EKglQdebc3MS6RFjasS6LPeWuWgfOgPIh1a6Vk=\n"
 		"-----END CERTIFICATE-----\n"
-		"\n";
-	cert +=
+		"\n"
 		"# GeoTrust Primary Certification Authority - G2\n"
 		"-----BEGIN CERTIFICATE-----\n"
 		"MIICrjCCAjWgAwIBAgIQPLL0SAoA4v7rJDteYD7DazAKBggqhkjOPQQDAzCBmDEL\n"
@@ -1567,8 +1519,7 @@ load_root_certificates(ssl::context& ctx, boost::system::error_code& ec)
 		"qQ7mndwxHLKgpxgceeHHNgIwOlavmnRs9vuD4DPTCF+hnMJbn0bWtsuRBmOiBucz\n"
 		"rD6ogRLQy7rQkgu2npaqBA+K\n"
 		"-----END CERTIFICATE-----\n"
-		"\n";
-	cert +=
+		"\n"
 		"# GeoTrust Primary Certification Authority - G3\n"
 		"-----BEGIN CERTIFICATE-----\n"
 		"MIID/jCCAuagAwIBAgIQFaxulBmyeUtB9iepwxgPHzANBgkqhkiG9w0BAQsFADCB\n"
@@ -1594,8 +1545,7 @@ load_root_certificates(ssl::context& ctx, boost::system::error_code& ec)
 		"SJsMC8tJP33st/3LjWeJGqvtux6jAAgIFyqCXDFdRootD4abdNlF+9RAsXqqaC2G\n"
 		"spki4cErx5z481+oghLrGREt\n"
 		"-----END CERTIFICATE-----\n"
-		"\n";
-	cert +=
+		"\n"
 		"# GeoTrust Universal CA\n"
 		"-----BEGIN CERTIFICATE-----\n"
 		"MIIFaDCCA1CgAwIBAgIBATANBgkqhkiG9w0BAQUFADBFMQswCQYDVQQGEwJVUzEW\n"
@@ -1628,8 +1578,7 @@ load_root_certificates(ssl::context& ctx, boost::system::error_code& ec)
 		"DF4JbAiXfKM9fJP/P6EUp8+1Xevb2xzEdt+Iub1FBZUbrvxGakyvSOPOrg/Sfuvm\n"
 		"bJxPgWp6ZKy7PtXny3YuxadIwVyQD8vIP/rmMuGNG2+k5o7Y+SlIis5z/iw=\n"
 		"-----END CERTIFICATE-----\n"
-		"\n";
-	cert +=
+		"\n"
 		"# GeoTrust Universal CA 2\n"
 		"-----BEGIN CERTIFICATE-----\n"
 		"MIIFbDCCA1SgAwIBAgIBATANBgkqhkiG9w0BAQUFADBHMQswCQYDVQQGEwJVUzEW\n"
@@ -1662,8 +1611,7 @@ load_root_certificates(ssl::context& ctx, boost::system::error_code& ec)
 		"6aLcr34YEoP9VhdBLtUpgn2Z9DH2canPLAEnpQW5qrJITirvn5NSUZU8UnOOVkwX\n"
 		"QMAJKOSLakhT2+zNVVXxxvjpoixMptEmX36vWkzaH6byHCx+rgIW0lbQL1dTR+iS\n"
 		"-----END CERTIFICATE-----\n"
-		"\n";
-	cert +=
+		"\n"
 		"# GlobalSign ECC Root CA - R4\n"
 		"-----BEGIN CERTIFICATE-----\n"
 		"MIIB4TCCAYegAwIBAgIRKjikHJYKBN5CsiilC+g0mAIwCgYIKoZIzj0EAwIwUDEk\n"
@@ -1678,8 +1626,7 @@ load_root_certificates(ssl::context& ctx, boost::system::error_code& ec)
 		"kPoUVy0D7O48027KqGx2vKLeuwIgJ6iFJzWbVsaj8kfSt24bAgAXqmemFZHe+pTs\n"
 		"ewv4n4Q=\n"
 		"-----END CERTIFICATE-----\n"
-		"\n";
-	cert +=
+		"\n"
 		"# GlobalSign ECC Root CA - R5\n"
 		"-----BEGIN CERTIFICATE-----\n"
 		"MIICHjCCAaSgAwIBAgIRYFlJ4CYuu1X5CneKcflK2GwwCgYIKoZIzj0EAwMwUDEk\n"
@@ -1695,8 +1642,7 @@ load_root_certificates(ssl::context& ctx, boost::system::error_code& ec)
 		"515dTguDnFt2KaAJJiFqYgIwcdK1j1zqO+F4CYWodZI7yFz9SO8NdCKoCOJuxUnO\n"
 		"xwy8p2Fp8fc74SrL+SvzZpA3\n"
 		"-----END CERTIFICATE-----\n"
-		"\n";
-	cert +=
+		"\n"
 		"# GlobalSign Root CA\n"
 		"-----BEGIN CERTIFICATE-----\n"
 		"MIIDdTCCAl2gAwIBAgILBAAAAAABFUtaw5QwDQYJKoZIhvcNAQEFBQAwVzELMAkG\n"
@@ -1719,8 +1665,7 @@ load_root_certificates(ssl::context& ctx, boost::system::error_code& ec)
 		"DKqC5JlR3XC321Y9YeRq4VzW9v493kHMB65jUr9TU/Qr6cf9tveCX4XSQRjbgbME\n"
 		"HMUfpIBvFSDJ3gyICh3WZlXi/EjJKSZp4A==\n"
 		"-----END CERTIFICATE-----\n"
-		"\n";
-	cert +=
+		"\n"
 		"# GlobalSign Root CA - R2\n"
 		"-----BEGIN CERTIFICATE-----\n"
 		"MIIDujCCAqKgAwIBAgILBAAAAAABD4Ym5g0wDQYJKoZIhvcNAQEFBQAwTDEgMB4G\n"
@@ -1744,8 +1689,7 @@ load_root_certificates(ssl::context& ctx, boost::system::error_code& ec)
 		"AfvDbbnvRG15RjF+Cv6pgsH/76tuIMRQyV+dTZsXjAzlAcmgQWpzU/qlULRuJQ/7\n"
 		"TBj0/VLZjmmx6BEP3ojY+x1J96relc8geMJgEtslQIxq/H5COEBkEveegeGTLg==\n"
 		"-----END CERTIFICATE-----\n"
-		"\n";
-	cert +=
+		"\n"
 		"# GlobalSign Root CA - R3\n"
 		"-----BEGIN CERTIFICATE-----\n"
 		"MIIDXzCCAkegAwIBAgILBAAAAAABIVhTCKIwDQYJKoZIhvcNAQELBQAwTDEgMB4G\n"
@@ -1768,8 +1712,7 @@ load_root_certificates(ssl::context& ctx, boost::system::error_code& ec)
 		"Mx86OyXShkDOOyyGeMlhLxS67ttVb9+E7gUJTb0o2HLO02JQZR7rkpeDMdmztcpH\n"
 		"WD9f\n"
 		"-----END CERTIFICATE-----\n"
-		"\n";
-	cert +=
+		"\n"
 		"# GlobalSign Root CA - R6\n"
 		"-----BEGIN CERTIFICATE-----\n"
 		"MIIFgzCCA2ugAwIBAgIORea7A4Mzw4VlSOb/RVEwDQYJKoZIhvcNAQEMBQAwTDEg\n"
@@ -1803,8 +1746,7 @@ load_root_certificates(ssl::context& ctx, boost::system::error_code& ec)
 		"8k8HWV+LLUNS60YMlOH1Zkd5d9VUWx+tJDfLRVpOoERIyNiwmcUVhAn21klJwGW4\n"
 		"5hpxbqCo8YLoRT5s1gLXCmeDBVrJpBA=\n"
 		"-----END CERTIFICATE-----\n"
-		"\n";
-	cert +=
+		"\n"
 		"# Global Chambersign Root - 2008\n"
 		"-----BEGIN CERTIFICATE-----\n"
 		"MIIHSTCCBTGgAwIBAgIJAMnN0+nVfSPOMA0GCSqGSIb3DQEBBQUAMIGsMQswCQYD\n"
@@ -1847,8 +1789,7 @@ load_root_certificates(ssl::context& ctx, boost::system::error_code& ec)
 		"v8CSlDQb4ye3ix5vQv/n6TebUB0tovkC7stYWDpxvGjjqsGvHCgfotwjZT+B6q6Z\n"
 		"09gwzxMNTxXJhLynSC34MCN32EZLeW32jO06f2ARePTpm67VVMB0gNELQp/B\n"
 		"-----END CERTIFICATE-----\n"
-		"\n";
-	cert +=
+		"\n"
 		"# Go Daddy Class 2 CA\n"
 		"-----BEGIN CERTIFICATE-----\n"
 		"MIIEADCCAuigAwIBAgIBADANBgkqhkiG9w0BAQUFADBjMQswCQYDVQQGEwJVUzEh\n"
@@ -1874,8 +1815,7 @@ load_root_certificates(ssl::context& ctx, boost::system::error_code& ec)
 		"dEr/VxqHD3VILs9RaRegAhJhldXRQLIQTO7ErBBDpqWeCtWVYpoNz4iCxTIM5Cuf\n"
 		"ReYNnyicsbkqWletNw+vHX/bvZ8=\n"
 		"-----END CERTIFICATE-----\n"
-		"\n";
-	cert +=
+		"\n"
 		"# Go Daddy Root Certificate Authority - G2\n"
 		"-----BEGIN CERTIFICATE-----\n"
 		"MIIDxTCCAq2gAwIBAgIBADANBgkqhkiG9w0BAQsFADCBgzELMAkGA1UEBhMCVVMx\n"
@@ -1900,8 +1840,7 @@ load_root_certificates(ssl::context& ctx, boost::system::error_code& ec)
 		"LPAvTK33sefOT6jEm0pUBsV/fdUID+Ic/n4XuKxe9tQWskMJDE32p2u0mYRlynqI\n"
 		"4uJEvlz36hz1\n"
 		"-----END CERTIFICATE-----\n"
-		"\n";
-	cert +=
+		"\n"
 		"# Hellenic Academic and Research Institutions ECC RootCA 2015\n"
 		"-----BEGIN CERTIFICATE-----\n"
 		"MIICwzCCAkqgAwIBAgIBADAKBggqhkjOPQQDAjCBqjELMAkGA1UEBhMCR1IxDzAN\n"
@@ -1920,8 +1859,7 @@ load_root_certificates(ssl::context& ctx, boost::system::error_code& ec)
 		"lSTAGiecMjvAwNW6qef4BENThe5SId6d9SWDPp5YSy/XZxMOIQIwBeF1Ad5o7Sof\n"
 		"TUwJCA3sS61kFyjndc5FZXIhF8siQQ6ME5g4mlRtm8rifOoCWCKR\n"
 		"-----END CERTIFICATE-----\n"
-		"\n";
-	cert +=
+		"\n"
 		"# Hellenic Academic and Research Institutions RootCA 2011\n"
 		"-----BEGIN CERTIFICATE-----\n"
 		"MIIEMTCCAxmgAwIBAgIBADANBgkqhkiG9w0BAQUFADCBlTELMAkGA1UEBhMCR1Ix\n"
@@ -1948,8 +1886,7 @@ load_root_certificates(ssl::context& ctx, boost::system::error_code& ec)
 		"Nnq/onN694/BtZqhFLKPM58N7yLcZnuEvUUXBj08yrl3NI/K6s8/MT7jiOOASSXI\n"
 		"l7WdmplNsDz4SgCbZN2fOUvRJ9e4\n"
 		"-----END CERTIFICATE-----\n"
-		"\n";
-	cert +=
+		"\n"
 		"# Hellenic Academic and Research Institutions RootCA 2015\n"
 		"-----BEGIN CERTIFICATE-----\n"
 		"MIIGCzCCA/OgAwIBAgIBADANBgkqhkiG9w0BAQsFADCBpjELMAkGA1UEBhMCR1Ix\n"
@@ -1986,8 +1923,7 @@ load_root_certificates(ssl::context& ctx, boost::system::error_code& ec)
 		"e7iG2rKPmT4dEw0SEe7Uq/DpFXYC5ODfqiAeW2GFZECpkJcNrVPSWh2HagCXZWK0\n"
 		"vm9qp/UsQu0yrbYhnr68\n"
 		"-----END CERTIFICATE-----\n"
-		"\n";
-	cert +=
+		"\n"
 		"# Hongkong Post Root CA 1\n"
 		"-----BEGIN CERTIFICATE-----\n"
 		"MIIDMDCCAhigAwIBAgICA+gwDQYJKoZIhvcNAQEFBQAwRzELMAkGA1UEBhMCSEsx\n"
@@ -2009,8 +1945,7 @@ load_root_certificates(ssl::context& ctx, boost::system::error_code& ec)
 		"fMGx+6fWtScvl6tu4B3i0RwsH0Ti/L6RoZz71ilTc4afU9hDDl3WY4JxHYB0yvbi\n"
 		"AmvZWg==\n"
 		"-----END CERTIFICATE-----\n"
-		"\n";
-	cert +=
+		"\n"
 		"# Hongkong Post Root CA 3\n"
 		"-----BEGIN CERTIFICATE-----\n"
 		"MIIFzzCCA7egAwIBAgIUCBZfikyl7ADJk0DfxMauI7gcWqQwDQYJKoZIhvcNAQEL\n"
@@ -2046,8 +1981,7 @@ load_root_certificates(ssl::context& ctx, boost::system::error_code& ec)
 		"LJstxabArahH9CdMOA0uG0k7UvToiIMrVCjU8jVStDKDYmlkDJGcn5fqdBb9HxEG\n"
 		"mpv0\n"
 		"-----END CERTIFICATE-----\n"
-		"\n";
-	cert +=
+		"\n"
 		"# ISRG Root X1\n"
 		"-----BEGIN CERTIFICATE-----\n"
 		"MIIFazCCA1OgAwIBAgIRAIIQz7DSQONZRGPgu2OCiwAwDQYJKoZIhvcNAQELBQAw\n"
@@ -2080,8 +2014,7 @@ load_root_certificates(ssl::context& ctx, boost::system::error_code& ec)
 		"mRGunUHBcnWEvgJBQl9nJEiU0Zsnvgc/ubhPgXRR4Xq37Z0j4r7g1SgEEzwxA57d\n"
 		"emyPxgcYxn/eR44/KJ4EBs+lVDR3veyJm+kXQ99b21/+jh5Xos1AnX5iItreGCc=\n"
 		"-----END CERTIFICATE-----\n"
-		"\n";
-	cert +=
+		"\n"
 		"# IdenTrust Commercial Root CA 1\n"
 		"-----BEGIN CERTIFICATE-----\n"
 		"MIIFYDCCA0igAwIBAgIQCgFCgAAAAUUjyES1AAAAAjANBgkqhkiG9w0BAQsFADBK\n"
@@ -2114,8 +2047,7 @@ load_root_certificates(ssl::context& ctx, boost::system::error_code& ec)
 		"mUlO+KWA2yUPHGNiiskzZ2s8EIPGrd6ozRaOjfAHN3Gf8qv8QfXBi+wAN10J5U6A\n"
 		"7/qxXDgGpRtK4dw4LTzcqx+QGtVKnO7RcGzM7vRX+Bi6hG6H\n"
 		"-----END CERTIFICATE-----\n"
-		"\n";
-	cert +=
+		"\n"
 		"# IdenTrust Public Sector Root CA 1\n"
 		"-----BEGIN CERTIFICATE-----\n"
 		"MIIFZjCCA06gAwIBAgIQCgFCgAAAAUUjz0Z8AAAAAjANBgkqhkiG9w0BAQsFADBN\n"
@@ -2148,8 +2080,7 @@ load_root_certificates(ssl::context& ctx, boost::system::error_code& ec)
 		"GaQdp/lLQzfcaFpPz+vCZHTetBXZ9FRUGi8c15dxVJCO2SCdUyt/q4/i6jC8UDfv\n"
 		"8Ue1fXwsBOxonbRJRBD0ckscZOf85muQ3Wl9af0AVqW3rLatt8o+Ae+c\n"
 		"-----END CERTIFICATE-----\n"
-		"\n";
-	cert +=
+		"\n"
 		"# Izenpe.com\n"
 		"-----BEGIN CERTIFICATE-----\n"
 		"MIIF8TCCA9mgAwIBAgIQALC3WhZIX7/hy/WL1xnmfTANBgkqhkiG9w0BAQsFADA4\n"
@@ -2185,8 +2116,7 @@ load_root_certificates(ssl::context& ctx, boost::system::error_code& ec)
 		"naM8THLCV8Sg1Mw4J87VBp6iSNnpn86CcDaTmjvfliHjWbcM2pE38P1ZWrOZyGls\n"
 		"QyYBNWNgVYkDOnXYukrZVP/u3oDYLdE41V4tC5h9Pmzb/CaIxw==\n"
 		"-----END CERTIFICATE-----\n"
-		"\n";
-	cert +=
+		"\n"
 		"# LuxTrust Global Root 2\n"
 		"-----BEGIN CERTIFICATE-----\n"
 		"MIIFwzCCA6ugAwIBAgIUCn6m30tEntpqJIWe5rgV0xZ/u7EwDQYJKoZIhvcNAQEL\n"
@@ -2221,8 +2151,7 @@ load_root_certificates(ssl::context& ctx, boost::system::error_code& ec)
 		"x9CWttrhSmQGbmBNvUJO/3jaJMobtNeWOWyu8Q6qp31IiyBMz2TWuJdGsE7RKlY6\n"
 		"oJO9r4Ak4Ap+58rVyuiFVdw2KuGUaJPHZnJED4AhMmwlxyOAgwrr\n"
 		"-----END CERTIFICATE-----\n"
-		"\n";
-	cert +=
+		"\n"
 		"# Microsec e-Szigno Root CA 2009\n"
 		"-----BEGIN CERTIFICATE-----\n"
 		"MIIECjCCAvKgAwIBAgIJAMJ+QwRORz8ZMA0GCSqGSIb3DQEBCwUAMIGCMQswCQYD\n"
@@ -2248,8 +2177,7 @@ load_root_certificates(ssl::context& ctx, boost::system::error_code& ec)
 		"2Pm2G2JwCz02yULyMtd6YebS2z3PyKnJm9zbWETXbzivf3jTo60adbocwTZ8jx5t\n"
 		"HMN1Rq41Bab2XD0h7lbwyYIiLXpUq3DDfSJlgnCW\n"
 		"-----END CERTIFICATE-----\n"
-		"\n";
-	cert +=
+		"\n"
 		"# NetLock Arany (Class Gold) Főtanúsítvány\n"
 		"-----BEGIN CERTIFICATE-----\n"
 		"MIIEFTCCAv2gAwIBAgIGSUEs5AAQMA0GCSqGSIb3DQEBCwUAMIGnMQswCQYDVQQG\n"
@@ -2275,8 +2203,7 @@ load_root_certificates(ssl::context& ctx, boost::system::error_code& ec)
 		"uLjbvrW5KfnaNwUASZQDhETnv0Mxz3WLJdH0pmT1kvarBes96aULNmLazAZfNou2\n"
 		"XjG4Kvte9nHfRCaexOYNkbQudZWAUWpLMKawYqGT8ZvYzsRjdT9ZR7E=\n"
 		"-----END CERTIFICATE-----\n"
-		"\n";
-	cert +=
+		"\n"
 		"# Network Solutions Certificate Authority\n"
 		"-----BEGIN CERTIFICATE-----\n"
 		"MIID5jCCAs6gAwIBAgIQV8szb8JcFuZHFhfjkDFo4DANBgkqhkiG9w0BAQUFADBi\n"
@@ -2301,8 +2228,7 @@ load_root_certificates(ssl::context& ctx, boost::system::error_code& ec)
 		"wKeI8lN3s2Berq4o2jUsbzRF0ybh3uxbTydrFny9RAQYgrOJeRcQcT16ohZO9QHN\n"
 		"pGxlaKFJdlxDydi8NmdspZS11My5vWo1ViHe2MPr+8ukYEywVaCge1ey\n"
 		"-----END CERTIFICATE-----\n"
-		"\n";
-	cert +=
+		"\n"
 		"# OISTE WISeKey Global Root GA CA\n"
 		"-----BEGIN CERTIFICATE-----\n"
 		"MIID8TCCAtmgAwIBAgIQQT1yx/RrH4FDffHSKFTfmjANBgkqhkiG9w0BAQUFADCB\n"
@@ -2328,8 +2254,7 @@ load_root_certificates(ssl::context& ctx, boost::system::error_code& ec)
 		"Fj4A4xylNoEYokxSdsARo27mHbrjWr42U8U+dY+GaSlYU7Wcu2+fXMUY7N0v4ZjJ\n"
 		"/L7fCg0=\n"
 		"-----END CERTIFICATE-----\n"
-		"\n";
-	cert +=
+		"\n"
 		"# OISTE WISeKey Global Root GB CA\n"
 		"-----BEGIN CERTIFICATE-----\n"
 		"MIIDtTCCAp2gAwIBAgIQdrEgUnTwhYdGs/gjGvbCwDANBgkqhkiG9w0BAQsFADBt\n"
@@ -2353,8 +2278,7 @@ load_root_certificates(ssl::context& ctx, boost::system::error_code& ec)
 		"aPFlTc58Bd9TZaml8LGXBHAVRgOY1NK/VLSgWH1Sb9pWJmLU2NuJMW8c8CLC02Ic\n"
 		"Nc1MaRVUGpCY3useX8p3x8uOPUNpnJpY0CQ73xtAln41rYHHTnG6iBM=\n"
 		"-----END CERTIFICATE-----\n"
-		"\n";
-	cert +=
+		"\n"
 		"# OISTE WISeKey Global Root GC CA\n"
 		"-----BEGIN CERTIFICATE-----\n"
 		"MIICaTCCAe+gAwIBAgIQISpWDK7aDKtARb8roi066jAKBggqhkjOPQQDAzBtMQsw\n"
@@ -2371,8 +2295,7 @@ load_root_certificates(ssl::context& ctx, boost::system::error_code& ec)
 		"57LnyAyMjMPdeYwbY9XJUpROTYJKcx6ygISpJcBMWm1JKWB4E+J+SOtkAjEA2zQg\n"
 		"Mgj/mkkCtojeFK9dbJlxjRo/i9fgojaGHAeCOnZT/cKi7e97sIBPWA9LUzm9\n"
 		"-----END CERTIFICATE-----\n"
-		"\n";
-	cert +=
+		"\n"
 		"# QuoVadis Root CA\n"
 		"-----BEGIN CERTIFICATE-----\n"
 		"MIIF0DCCBLigAwIBAgIEOrZQizANBgkqhkiG9w0BAQUFADB/MQswCQYDVQQGEwJC\n"
@@ -2408,8 +2331,7 @@ load_root_certificates(ssl::context& ctx, boost::system::error_code& ec)
 		"xFIY6iHOsfHmhIHluqmGKPJDWl0Snawe2ajlCmqnf6CHKc/yiU3U7MXi5nrQNiOK\n"
 		"SnQ2+Q==\n"
 		"-----END CERTIFICATE-----\n"
-		"\n";
-	cert +=
+		"\n"
 		"# QuoVadis Root CA 1 G3\n"
 		"-----BEGIN CERTIFICATE-----\n"
 		"MIIFYDCCA0igAwIBAgIUeFhfLq0sGUvjNwc1NBMotZbUZZMwDQYJKoZIhvcNAQEL\n"
@@ -2442,8 +2364,7 @@ load_root_certificates(ssl::context& ctx, boost::system::error_code& ec)
 		"q1467HxpvMc7hU6eFbm0FU/DlXpY18ls6Wy58yljXrQs8C097Vpl4KlbQMJImYFt\n"
 		"nh8GKjwStIsPm6Ik8KaN1nrgS7ZklmOVhMJKzRwuJIczYOXD\n"
 		"-----END CERTIFICATE-----\n"
-		"\n";
-	cert +=
+		"\n"
 		"# QuoVadis Root CA 2\n"
 		"-----BEGIN CERTIFICATE-----\n"
 		"MIIFtzCCA5+gAwIBAgICBQkwDQYJKoZIhvcNAQEFBQAwRTELMAkGA1UEBhMCQk0x\n"
@@ -2478,8 +2399,7 @@ load_root_certificates(ssl::context& ctx, boost::system::error_code& ec)
 		"4aOTHcyKJloJONDO1w2AFrR4pTqHTI2KpdVGl/IsELm8VCLAAVBpQ570su9t+Oza\n"
 		"8eOx79+Rj1QqCyXBJhnEUhAFZdWCEOrCMc0u\n"
 		"-----END CERTIFICATE-----\n"
-		"\n";
-	cert +=
+		"\n"
 		"# QuoVadis Root CA 2 G3\n"
 		"-----BEGIN CERTIFICATE-----\n"
 		"MIIFYDCCA0igAwIBAgIURFc0JFuBiZs18s64KztbpybwdSgwDQYJKoZIhvcNAQEL\n"
@@ -2512,8 +2432,7 @@ load_root_certificates(ssl::context& ctx, boost::system::error_code& ec)
 		"HVOyToV7BjjHLPj4sHKNJeV3UvQDHEimUF+IIDBu8oJDqz2XhOdT+yHBTw8imoa4\n"
 		"WSr2Rz0ZiC3oheGe7IUIarFsNMkd7EgrO3jtZsSOeWmD3n+M\n"
 		"-----END CERTIFICATE-----\n"
-		"\n";
-	cert +=
+		"\n"
 		"# QuoVadis Root CA 3\n"
 		"-----BEGIN CERTIFICATE-----\n"
 		"MIIGnTCCBIWgAwIBAgICBcYwDQYJKoZIhvcNAQEFBQAwRTELMAkGA1UEBhMCQk0x\n"
@@ -2553,8 +2472,7 @@ load_root_certificates(ssl::context& ctx, boost::system::error_code& ec)
 		"mJlglFwjz1onl14LBQaTNx47aTbrqZ5hHY8y2o4M1nQ+ewkk2gF3R8Q7zTSMmfXK\n"
 		"4SVhM7JZG+Ju1zdXtg2pEto=\n"
 		"-----END CERTIFICATE-----\n"
-		"\n";
-	cert +=
+		"\n"
 		"# QuoVadis Root CA 3 G3\n"
 		"-----BEGIN CERTIFICATE-----\n"
 		"MIIFYDCCA0igAwIBAgIULvWbAiin23r/1aOp7r0DoM8Sah0wDQYJKoZIhvcNAQEL\n"
@@ -2587,8 +2505,7 @@ load_root_certificates(ssl::context& ctx, boost::system::error_code& ec)
 		"PlopNLk9hM6xZdRZkZFWdSHBd575euFgndOtBBj0fOtek49TSiIp+EgrPk2GrFt/\n"
 		"ywaZWWDYWGWVjUTR939+J399roD1B0y2PpxxVJkES/1Y+Zj0\n"
 		"-----END CERTIFICATE-----\n"
-		"\n";
-	cert +=
+		"\n"
 		"# SSL.com EV Root Certification Authority ECC\n"
 		"-----BEGIN CERTIFICATE-----\n"
 		"MIIClDCCAhqgAwIBAgIILCmcWxbtBZUwCgYIKoZIzj0EAwIwfzELMAkGA1UEBhMC\n"
@@ -2606,8 +2523,7 @@ load_root_certificates(ssl::context& ctx, boost::system::error_code& ec)
 		"ytRrJPOwPYdGWBrssd9v+1a6cGvHOMzosYxPD/fxZ3YOg9AeUY8CMD32IygmTMZg\n"
 		"h5Mmm7I1HrrW9zzRHM76JTymGoEVW/MSD2zuZYrJh6j5B+BimoxcSg==\n"
 		"-----END CERTIFICATE-----\n"
-		"\n";
-	cert +=
+		"\n"
 		"# SSL.com EV Root Certification Authority RSA R2\n"
 		"-----BEGIN CERTIFICATE-----\n"
 		"MIIF6zCCA9OgAwIBAgIIVrYpzTS8ePYwDQYJKoZIhvcNAQELBQAwgYIxCzAJBgNV\n"
@@ -2643,8 +2559,7 @@ load_root_certificates(ssl::context& ctx, boost::system::error_code& ec)
 		"S9EOUCXdywMMF8mDAAhONU2Ki+3wApRmLER/y5UnlhetCTCstnEXbosX9hwJ1C07\n"
 		"mKVx01QT2WDz9UtmT/rx7iASjbSsV7FFY6GsdqnC+w==\n"
 		"-----END CERTIFICATE-----\n"
-		"\n";
-	cert +=
+		"\n"
 		"# SSL.com Root Certification Authority ECC\n"
 		"-----BEGIN CERTIFICATE-----\n"
 		"MIICjTCCAhSgAwIBAgIIdebfy8FoW6gwCgYIKoZIzj0EAwIwfDELMAkGA1UEBhMC\n"
@@ -2662,8 +2577,7 @@ load_root_certificates(ssl::context& ctx, boost::system::error_code& ec)
 		"kdzt5fxQaxFGRrMcIQBiu77D5+jNB5n5DQtdcj7EqgIwH7y6C+IwJPt8bYBVCpk+\n"
 		"gA0z5Wajs6O7pdWLjwkspl1+4vAHCGht0nxpbl/f5Wpl\n"
 		"-----END CERTIFICATE-----\n"
-		"\n";
-	cert +=
+		"\n"
 		"# SSL.com Root Certification Authority RSA\n"
 		"-----BEGIN CERTIFICATE-----\n"
 		"MIIF3TCCA8WgAwIBAgIIeyyb0xaAMpkwDQYJKoZIhvcNAQELBQAwfDELMAkGA1UE\n"
@@ -2699,8 +2613,7 @@ load_root_certificates(ssl::context& ctx, boost::system::error_code& ec)
 		"oYYitmUnDuy2n0Jg5GfCtdpBC8TTi2EbvPofkSvXRAdeuims2cXp71NIWuuA8ShY\n"
 		"Ic2wBlX7Jz9TkHCpBB5XJ7k=\n"
 		"-----END CERTIFICATE-----\n"
-		"\n";
-	cert +=
+		"\n"
 		"# SZAFIR ROOT CA2\n"
 		"-----BEGIN CERTIFICATE-----\n"
 		"MIIDcjCCAlqgAwIBAgIUPopdB+xV0jLVt+O2XwHrLdzk1uQwDQYJKoZIhvcNAQEL\n"
@@ -2723,8 +2636,7 @@ load_root_certificates(ssl::context& ctx, boost::system::error_code& ec)
 		"d05DpYhfhmehPea0XGG2Ptv+tyjFogeutcrKjSoS75ftwjCkySp6+/NNIxuZMzSg\n"
 		"LvWpCz/UXeHPhJ/iGcJfitYgHuNztw==\n"
 		"-----END CERTIFICATE-----\n"
-		"\n";
-	cert +=
+		"\n"
 		"# SecureSign RootCA11\n"
 		"-----BEGIN CERTIFICATE-----\n"
 		"MIIDbTCCAlWgAwIBAgIBATANBgkqhkiG9w0BAQUFADBYMQswCQYDVQQGEwJKUDEr\n"
@@ -2747,8 +2659,7 @@ load_root_certificates(ssl::context& ctx, boost::system::error_code& ec)
 		"pPpyl4RTDaXQMhhRdlkUbA/r7F+AjHVDg8OFmP9Mni0N5HeDk061lgeLKBObjBmN\n"
 		"QSdJQO7e5iNEOdyhIta6A/I=\n"
 		"-----END CERTIFICATE-----\n"
-		"\n";
-	cert +=
+		"\n"
 		"# SecureTrust CA\n"
 		"-----BEGIN CERTIFICATE-----\n"
 		"MIIDuDCCAqCgAwIBAgIQDPCOXAgWpa1Cf/DrJxhZ0DANBgkqhkiG9w0BAQUFADBI\n"
@@ -2772,8 +2683,7 @@ load_root_certificates(ssl::context& ctx, boost::system::error_code& ec)
 		"CPyI6a6Lf+Ew9Dd+/cYy2i2eRDAwbO4H3tI0/NL/QPZL9GZGBlSm8jIKYyYwa5vR\n"
 		"3ItHuuG51WLQoqD0ZwV4KWMabwTW+MZMo5qxN7SN5ShLHZ4swrhovO0C7jE=\n"
 		"-----END CERTIFICATE-----\n"
-		"\n";
-	cert +=
+		"\n"
 		"# Secure Global CA\n"
 		"-----BEGIN CERTIFICATE-----\n"
 		"MIIDvDCCAqSgAwIBAgIQB1YipOjUiolN9BPI8PjqpTANBgkqhkiG9w0BAQUFADBK\n"
@@ -2797,8 +2707,7 @@ load_root_certificates(ssl::context& ctx, boost::system::error_code& ec)
 		"iNE6KTCEztI5gGIbqMdXSbxqVVFnFUq+NQfk1XWYN3kwFNspnWzFacxHVaIw98xc\n"
 		"f8LDmBxrThaA63p4ZUWiABqvDA1VZDRIuJK58bRQKfJPIx/abKwfROHdI3hRW8cW\n"
 		"-----END CERTIFICATE-----\n"
-		"\n";
-	cert +=
+		"\n"
 		"# Security Communication RootCA2\n"
 		"-----BEGIN CERTIFICATE-----\n"
 		"MIIDdzCCAl+gAwIBAgIBADANBgkqhkiG9w0BAQsFADBdMQswCQYDVQQGEwJKUDEl\n"
@@ -2821,8 +2730,7 @@ load_root_certificates(ssl::context& ctx, boost::system::error_code& ec)
 		"1UkC9gLl9B/rfNmWVan/7Ir5mUf/NVoCqgTLiluHcSmRvaS0eg29mvVXIwAHIRc/\n"
 		"SjnRBUkLp7Y3gaVdjKozXoEofKd9J+sAro03\n"
 		"-----END CERTIFICATE-----\n"
-		"\n";
-	cert +=
+		"\n"
 		"# Security Communication Root CA\n"
 		"-----BEGIN CERTIFICATE-----\n"
 		"MIIDWjCCAkKgAwIBAgIBADANBgkqhkiG9w0BAQUFADBQMQswCQYDVQQGEwJKUDEY\n"
@@ -2844,8 +2752,7 @@ load_root_certificates(ssl::context& ctx, boost::system::error_code& ec)
 		"JRDL8Try2frbSVa7pv6nQTXD4IhhyYjH3zYQIphZ6rBK+1YWc26sTfcioU+tHXot\n"
 		"RSflMMFe8toTyyVCUZVHA4xsIcx0Qu1T/zOLjw9XARYvz6buyXAiFL39vmwLAw==\n"
 		"-----END CERTIFICATE-----\n"
-		"\n";
-	cert +=
+		"\n"
 		"# Sonera Class 2 Root CA\n"
 		"-----BEGIN CERTIFICATE-----\n"
 		"MIIDIDCCAgigAwIBAgIBHTANBgkqhkiG9w0BAQUFADA5MQswCQYDVQQGEwJGSTEP\n"
@@ -2866,8 +2773,7 @@ load_root_certificates(ssl::context& ctx, boost::system::error_code& ec)
 		"Tk6ezAyNlNzZRZxe7EJQY670XcSxEtzKO6gunRRaBXW37Ndj4ro1tgQIkejanZz2\n"
 		"ZrUYrAqmVCY0M9IbwdR/GjqOC6oybtv8TyWf2TLHllpwrN9M\n"
 		"-----END CERTIFICATE-----\n"
-		"\n";
-	cert +=
+		"\n"
 		"# Staat der Nederlanden EV Root CA\n"
 		"-----BEGIN CERTIFICATE-----\n"
 		"MIIFcDCCA1igAwIBAgIEAJiWjTANBgkqhkiG9w0BAQsFADBYMQswCQYDVQQGEwJO\n"
@@ -2901,8 +2807,7 @@ load_root_certificates(ssl::context& ctx, boost::system::error_code& ec)
 		"FVdMpEbB4IMeDExNH08GGeL5qPQ6gqGyeUN51q1veieQA6TqJIc/2b3Z6fJfUEkc\n"
 		"7uzXLg==\n"
 		"-----END CERTIFICATE-----\n"
-		"\n";
-	cert +=
+		"\n"
 		"# Staat der Nederlanden Root CA - G3\n"
 		"-----BEGIN CERTIFICATE-----\n"
 		"MIIFdDCCA1ygAwIBAgIEAJiiOTANBgkqhkiG9w0BAQsFADBaMQswCQYDVQQGEwJO\n"
@@ -2936,8 +2841,7 @@ load_root_certificates(ssl::context& ctx, boost::system::error_code& ec)
 		"QFH1T/U67cjF68IeHRaVesd+QnGTbksVtzDfqu1XhUisHWrdOWnk4Xl4vs4Fv6EM\n"
 		"94B7IWcnMFk=\n"
 		"-----END CERTIFICATE-----\n"
-		"\n";
-	cert +=
+		"\n"
 		"# Starfield Class 2 CA\n"
 		"-----BEGIN CERTIFICATE-----\n"
 		"MIIEDzCCAvegAwIBAgIBADANBgkqhkiG9w0BAQUFADBoMQswCQYDVQQGEwJVUzEl\n"
@@ -2963,8 +2867,7 @@ load_root_certificates(ssl::context& ctx, boost::system::error_code& ec)
 		"VSJYACPq4xJDKVtHCN2MQWplBqjlIapBtJUhlbl90TSrE9atvNziPTnNvT51cKEY\n"
 		"WQPJIrSPnNVeKtelttQKbfi3QBFGmh95DmK/D5fs4C8fF5Q=\n"
 		"-----END CERTIFICATE-----\n"
-		"\n";
-	cert +=
+		"\n"
 		"# Starfield Root Certificate Authority - G2\n"
 		"-----BEGIN CERTIFICATE-----\n"
 		"MIID3TCCAsWgAwIBAgIBADANBgkqhkiG9w0BAQsFADCBjzELMAkGA1UEBhMCVVMx\n"
@@ -2989,8 +2892,7 @@ load_root_certificates(ssl::context& ctx, boost::system::error_code& ec)
 		"pL/QlwVKvOoYKAKQvVR4CSFx09F9HdkWsKlhPdAKACL8x3vLCWRFCztAgfd9fDL1\n"
 		"mMpYjn0q7pBZc2T5NnReJaH1ZgUufzkVqSr7UIuOhWn0\n"
 		"-----END CERTIFICATE-----\n"
-		"\n";
-	cert +=
+		"\n"
 		"# Starfield Services Root Certificate Authority - G2\n"
 		"-----BEGIN CERTIFICATE-----\n"
 		"MIID7zCCAtegAwIBAgIBADANBgkqhkiG9w0BAQsFADCBmDELMAkGA1UEBhMCVVMx\n"
@@ -3016,8 +2918,7 @@ load_root_certificates(ssl::context& ctx, boost::system::error_code& ec)
 		"0q23KXB56jzaYyWf/Wi3MOxw+3WKt21gZ7IeyLnp2KhvAotnDU0mV3HaIPzBSlCN\n"
 		"sSi6\n"
 		"-----END CERTIFICATE-----\n"
-		"\n";
-	cert +=
+		"\n"
 		"# SwissSign Gold CA - G2\n"
 		"-----BEGIN CERTIFICATE-----\n"
 		"MIIFujCCA6KgAwIBAgIJALtAHEP1Xk+wMA0GCSqGSIb3DQEBBQUAMEUxCzAJBgNV\n"
@@ -3052,8 +2953,7 @@ load_root_certificates(ssl::context& ctx, boost::system::error_code& ec)
 		"ZMEBnunKoGqYDs/YYPIvSbjkQuE4NRb0yG5P94FW6LqjviOvrv1vA+ACOzB2+htt\n"
 		"Qc8Bsem4yWb02ybzOqR08kkkW8mw0FfB+j564ZfJ\n"
 		"-----END CERTIFICATE-----\n"
-		"\n";
-	cert +=
+		"\n"
 		"# SwissSign Silver CA - G2\n"
 		"-----BEGIN CERTIFICATE-----\n"
 		"MIIFvTCCA6WgAwIBAgIITxvUL1S7L0swDQYJKoZIhvcNAQEFBQAwRzELMAkGA1UE\n"
@@ -3088,8 +2988,7 @@ load_root_certificates(ssl::context& ctx, boost::system::error_code& ec)
 		"hAhm0sQ2fac+EPyI4NSA5QC9qvNOBqN6avlicuMJT+ubDgEj8Z+7fNzcbBGXJbLy\n"
 		"tGMU0gYqZ4yD9c7qB9iaah7s5Aq7KkzrCWA5zspi2C5u\n"
 		"-----END CERTIFICATE-----\n"
-		"\n";
-	cert +=
+		"\n"
 		"# T-TeleSec GlobalRoot Class 2\n"
 		"-----BEGIN CERTIFICATE-----\n"
 		"MIIDwzCCAqugAwIBAgIBATANBgkqhkiG9w0BAQsFADCBgjELMAkGA1UEBhMCREUx\n"
@@ -3114,8 +3013,7 @@ load_root_certificates(ssl::context& ctx, boost::system::error_code& ec)
 		"9noHV8cigwUtPJslJj0Ys6lDfMjIq2SPDqO/nBudMNva0Bkuqjzx+zOAduTNrRlP\n"
 		"BSeOE6Fuwg==\n"
 		"-----END CERTIFICATE-----\n"
-		"\n";
-	cert +=
+		"\n"
 		"# T-TeleSec GlobalRoot Class 3\n"
 		"-----BEGIN CERTIFICATE-----\n"
 		"MIIDwzCCAqugAwIBAgIBATANBgkqhkiG9w0BAQsFADCBgjELMAkGA1UEBhMCREUx\n"
@@ -3140,8 +3038,7 @@ load_root_certificates(ssl::context& ctx, boost::system::error_code& ec)
 		"e9eiPZaGzPImNC1qkp2aGtAw4l1OBLBfiyB+d8E9lYLRRpo7PHi4b6HQDWSieB4p\n"
 		"TpPDpFQUWw==\n"
 		"-----END CERTIFICATE-----\n"
-		"\n";
-	cert +=
+		"\n"
 		"# TUBITAK Kamu SM SSL Kok Sertifikasi - Surum 1\n"
 		"-----BEGIN CERTIFICATE-----\n"
 		"MIIEYzCCA0ugAwIBAgIBATANBgkqhkiG9w0BAQsFADCB0jELMAkGA1UEBhMCVFIx\n"
@@ -3169,8 +3066,7 @@ load_root_certificates(ssl::context& ctx, boost::system::error_code& ec)
 		"8jEyVupk+eq1nRZmQnLzf9OxMUP8pI4X8W0jq5Rm+K37DwhuJi1/FwcJsoz7UMCf\n"
 		"lo3Ptv0AnVoUmr8CRPXBwp8iXqIPoeM=\n"
 		"-----END CERTIFICATE-----\n"
-		"\n";
-	cert +=
+		"\n"
 		"# TWCA Global Root CA\n"
 		"-----BEGIN CERTIFICATE-----\n"
 		"MIIFQTCCAymgAwIBAgICDL4wDQYJKoZIhvcNAQELBQAwUTELMAkGA1UEBhMCVFcx\n"
@@ -3203,8 +3099,7 @@ load_root_certificates(ssl::context& ctx, boost::system::error_code& ec)
 		"aGHQRiapIVJpLesux+t3zqY6tQMzT3bR51xUAV3LePTJDL/PEo4XLSNolOer/qmy\n"
 		"KwbQBM0=\n"
 		"-----END CERTIFICATE-----\n"
-		"\n";
-	cert +=
+		"\n"
 		"# TWCA Root Certification Authority\n"
 		"-----BEGIN CERTIFICATE-----\n"
 		"MIIDezCCAmOgAwIBAgIBATANBgkqhkiG9w0BAQUFADBfMQswCQYDVQQGEwJUVzES\n"
@@ -3227,8 +3122,7 @@ load_root_certificates(ssl::context& ctx, boost::system::error_code& ec)
 		"aspHYcN6+NOSBB+4IIThNlQWx0DeO4pz3N/GCUzf7Nr/1FNCocnyYh0igzyXxfkZ\n"
 		"YiesZSLX0zzG5Y6yU8xJzrww/nsOM5D77dIUkR8Hrw==\n"
 		"-----END CERTIFICATE-----\n"
-		"\n";
-	cert +=
+		"\n"
 		"# Taiwan GRCA\n"
 		"-----BEGIN CERTIFICATE-----\n"
 		"MIIFcjCCA1qgAwIBAgIQH51ZWtcvwgZEpYAIaeNe9jANBgkqhkiG9w0BAQUFADA/\n"
@@ -3262,8 +3156,7 @@ load_root_certificates(ssl::context& ctx, boost::system::error_code& ec)
 		"LMDDav7v3Aun+kbfYNucpllQdSNpc5Oy+fwC00fmcc4QAu4njIT/rEUNE1yDMuAl\n"
 		"pYYsfPQS\n"
 		"-----END CERTIFICATE-----\n"
-		"\n";
-	cert +=
+		"\n"
 		"# TeliaSonera Root CA v1\n"
 		"-----BEGIN CERTIFICATE-----\n"
 		"MIIFODCCAyCgAwIBAgIRAJW+FqD3LkbxezmCcvqLzZYwDQYJKoZIhvcNAQEFBQAw\n"
@@ -3295,8 +3188,7 @@ load_root_certificates(ssl::context& ctx, boost::system::error_code& ec)
 		"HL/EVlP6Y2XQ8xwOFvVrhlhNGNTkDY6lnVuR3HYkUD/GKvvZt5y11ubQ2egZixVx\n"
 		"SK236thZiNSQvxaz2emsWWFUyBy6ysHK4bkgTI86k4mloMy/0/Z1pHWWbVY=\n"
 		"-----END CERTIFICATE-----\n"
-		"\n";
-	cert +=
+		"\n"
 		"# TrustCor ECA-1\n"
 		"-----BEGIN CERTIFICATE-----\n"
 		"MIIEIDCCAwigAwIBAgIJAISCLF8cYtBAMA0GCSqGSIb3DQEBCwUAMIGcMQswCQYD\n"
@@ -3323,8 +3215,7 @@ load_root_certificates(ssl::context& ctx, boost::system::error_code& ec)
 		"WJZpTdwHjFGTot+fDz2LYLSCjaoITmJF4PkL0uDgPFveXHEnJcLmA4GLEFPjx1Wi\n"
 		"tJ/X5g==\n"
 		"-----END CERTIFICATE-----\n"
-		"\n";
-	cert +=
+		"\n"
 		"# TrustCor RootCert CA-1\n"
 		"-----BEGIN CERTIFICATE-----\n"
 		"MIIEMDCCAxigAwIBAgIJANqb7HHzA7AZMA0GCSqGSIb3DQEBCwUAMIGkMQswCQYD\n"
@@ -3351,8 +3242,7 @@ load_root_certificates(ssl::context& ctx, boost::system::error_code& ec)
 		"L1Ac59v2Z3kf9YKVmgenFK+P3CghZwnS1k1aHBkcjndcw5QkPTJrS37UeJSDvjdN\n"
 		"zl/HHk484IkzlQsPpTLWPFp5LBk=\n"
 		"-----END CERTIFICATE-----\n"
-		"\n";
-	cert +=
+		"\n"
 		"# TrustCor RootCert CA-2\n"
 		"-----BEGIN CERTIFICATE-----\n"
 		"MIIGLzCCBBegAwIBAgIIJaHfyjPLWQIwDQYJKoZIhvcNAQELBQAwgaQxCzAJBgNV\n"
@@ -3390,8 +3280,7 @@ load_root_certificates(ssl::context& ctx, boost::system::error_code& ec)
 		"5KeXRKQOKIETNcX2b2TmQcTVL8w0RSXPQQCWPUouwpaYT05KnJe32x+SMsj/D1Fu\n"
 		"1uwJ\n"
 		"-----END CERTIFICATE-----\n"
-		"\n";
-	cert +=
+		"\n"
 		"# Trustis FPS Root CA\n"
 		"-----BEGIN CERTIFICATE-----\n"
 		"MIIDZzCCAk+gAwIBAgIQGx+ttiD5JNM2a/fH8YygWTANBgkqhkiG9w0BAQUFADBF\n"
@@ -3414,8 +3303,7 @@ load_root_certificates(ssl::context& ctx, boost::system::error_code& ec)
 		"jZBf3+6f9L/uHfuY5H+QK4R4EA5sSVPvFVtlRkpdr7r7OnIdzfYliB6XzCGcKQEN\n"
 		"ZetX2fNXlrtIzYE=\n"
 		"-----END CERTIFICATE-----\n"
-		"\n";
-	cert +=
+		"\n"
 		"# UCA Extended Validation Root\n"
 		"-----BEGIN CERTIFICATE-----\n"
 		"MIIFWjCCA0KgAwIBAgIQT9Irj/VkyDOeTzRYZiNwYDANBgkqhkiG9w0BAQsFADBH\n"
@@ -3448,8 +3336,7 @@ load_root_certificates(ssl::context& ctx, boost::system::error_code& ec)
 		"cmtpzyKEC2IPrNkZAJSidjzULZrtBJ4tBmIQN1IchXIbJ+XMxjHsN+xjWZsLHXbM\n"
 		"fjKaiJUINlK73nZfdklJrX+9ZSCyycErdhh2n1ax\n"
 		"-----END CERTIFICATE-----\n"
-		"\n";
-	cert +=
+		"\n"
 		"# UCA Global G2 Root\n"
 		"-----BEGIN CERTIFICATE-----\n"
 		"MIIFRjCCAy6gAwIBAgIQXd+x2lqj7V2+WmUgZQOQ7zANBgkqhkiG9w0BAQsFADA9\n"
@@ -3482,8 +3369,7 @@ load_root_certificates(ssl::context& ctx, boost::system::error_code& ec)
 		"YiGqhkCyLmTTX8jjfhFnRR8F/uOi77Oos/N9j/gMHyIfLXC0uAE0djAA5SN4p1bX\n"
 		"UB+K+wb1whnw0A==\n"
 		"-----END CERTIFICATE-----\n"
-		"\n";
-	cert +=
+		"\n"
 		"# USERTrust ECC Certification Authority\n"
 		"-----BEGIN CERTIFICATE-----\n"
 		"MIICjzCCAhWgAwIBAgIQXIuZxVqUxdJxVt7NiYDMJjAKBggqhkjOPQQDAzCBiDEL\n"
@@ -3501,8 +3387,7 @@ load_root_certificates(ssl::context& ctx, boost::system::error_code& ec)
 		"zzuqQhFkoJ2UOQIReVx7Hfpkue4WQrO/isIJxOzksU0CMQDpKmFHjFJKS04YcPbW\n"
 		"RNZu9YO6bVi9JNlWSOrvxKJGgYhqOkbRqZtNyWHa0V1Xahg=\n"
 		"-----END CERTIFICATE-----\n"
-		"\n";
-	cert +=
+		"\n"
 		"# USERTrust RSA Certification Authority\n"
 		"-----BEGIN CERTIFICATE-----\n"
 		"MIIF3jCCA8agAwIBAgIQAf1tMPyjylGoG7xkDjUDLTANBgkqhkiG9w0BAQwFADCB\n"
@@ -3538,8 +3423,7 @@ load_root_certificates(ssl::context& ctx, boost::system::error_code& ec)
 		"L6KCq9NjRHDEjf8tM7qtj3u1cIiuPhnPQCjY/MiQu12ZIvVS5ljFH4gxQ+6IHdfG\n"
 		"jjxDah2nGN59PRbxYvnKkKj9\n"
 		"-----END CERTIFICATE-----\n"
-		"\n";
-	cert +=
+		"\n"
 		"# VeriSign Class 3 Public Primary Certification Authority - G4\n"
 		"-----BEGIN CERTIFICATE-----\n"
 		"MIIDhDCCAwqgAwIBAgIQL4D+I4wOIg9IZxIokYesszAKBggqhkjOPQQDAzCByjEL\n"
@@ -3562,8 +3446,7 @@ load_root_certificates(ssl::context& ctx, boost::system::error_code& ec)
 		"4Kf8NoRRkSAsdk1DPcQdhCPQrNZ8NQbOzWm9kA3bbEhCHQ6qQgIxAJw9SDkjOVga\n"
 		"FRJZap7v1VmyHVIsmXHNxynfGyphe3HR3vPA5Q06Sqotp9iGKt0uEA==\n"
 		"-----END CERTIFICATE-----\n"
-		"\n";
-	cert +=
+		"\n"
 		"# VeriSign Class 3 Public Primary Certification Authority - G5\n"
 		"-----BEGIN CERTIFICATE-----\n"
 		"MIIE0zCCA7ugAwIBAgIQGNrRniZ96LtKIVjNzGs7SjANBgkqhkiG9w0BAQUFADCB\n"
@@ -3593,8 +3476,7 @@ load_root_certificates(ssl::context& ctx, boost::system::error_code& ec)
 		"4fQRbxC1lfznQgUy286dUV4otp6F01vvpX1FQHKOtw5rDgb7MzVIcbidJ4vEZV8N\n"
 		"hnacRHr2lVz2XTIIM6RUthg/aFzyQkqFOFSDX9HoLPKsEdao7WNq\n"
 		"-----END CERTIFICATE-----\n"
-		"\n";
-	cert +=
+		"\n"
 		"# VeriSign Universal Root Certification Authority\n"
 		"-----BEGIN CERTIFICATE-----\n"
 		"MIIEuTCCA6GgAwIBAgIQQBrEZCGzEyEDDrvkEhrFHTANBgkqhkiG9w0BAQsFADCB\n"
@@ -3624,8 +3506,7 @@ load_root_certificates(ssl::context& ctx, boost::system::error_code& ec)
 		"lRQOfc2VNNnSj3BzgXucfr2YYdhFh5iQxeuGMMY1v/D/w1WIg0vvBZIGcfK4mJO3\n"
 		"7M2CYfE45k+XmCpajQ==\n"
 		"-----END CERTIFICATE-----\n"
-		"\n";
-	cert +=
+		"\n"
 		"# Verisign Class 3 Public Primary Certification Authority - G3\n"
 		"-----BEGIN CERTIFICATE-----\n"
 		"MIIEGjCCAwICEQCbfgZJoz5iudXukEhxKe9XMA0GCSqGSIb3DQEBBQUAMIHKMQsw\n"
@@ -3651,8 +3532,7 @@ load_root_certificates(ssl::context& ctx, boost::system::error_code& ec)
 		"F4ErWjfJXir0xuKhXFSbplQAz/DxwceYMBo7Nhbbo27q/a2ywtrvAkcTisDxszGt\n"
 		"TxzhT5yvDwyd93gN2PQ1VoDat20Xj50egWTh/sVFuq1ruQp6Tk9LhO5L8X3dEQ==\n"
 		"-----END CERTIFICATE-----\n"
-		"\n";
-	cert +=
+		"\n"
 		"# XRamp Global CA Root\n"
 		"-----BEGIN CERTIFICATE-----\n"
 		"MIIEMDCCAxigAwIBAgIQUJRs7Bjq1ZxN1ZfvdY+grTANBgkqhkiG9w0BAQUFADCB\n"
@@ -3679,8 +3559,7 @@ load_root_certificates(ssl::context& ctx, boost::system::error_code& ec)
 		"i6mx5O+aGtA9aZnuqCij4Tyz8LIRnM98QObd50N9otg6tamN8jSZxNQQ4Qb9CYQQ\n"
 		"O+7ETPTsJ3xCwnR8gooJybQDJbw=\n"
 		"-----END CERTIFICATE-----\n"
-		"\n";
-	cert +=
+		"\n"
 		"# certSIGN ROOT CA\n"
 		"-----BEGIN CERTIFICATE-----\n"
 		"MIIDODCCAiCgAwIBAgIGIAYFFnACMA0GCSqGSIb3DQEBBQUAMDsxCzAJBgNVBAYT\n"
@@ -3702,8 +3581,7 @@ load_root_certificates(ssl::context& ctx, boost::system::error_code& ec)
 		"i/nDhDwTqn6Sm1dTk/pwwpEOMfmbZ13pljheX7NzTogVZ96edhBiIL5VaZVDADlN\n"
 		"9u6wWk5JRFRYX0KD\n"
 		"-----END CERTIFICATE-----\n"
-		"\n";
-	cert +=
+		"\n"
 		"# ePKI Root Certification Authority\n"
 		"-----BEGIN CERTIFICATE-----\n"
 		"MIIFsDCCA5igAwIBAgIQFci9ZUdcr7iXAF7kBtK8nTANBgkqhkiG9w0BAQUFADBe\n"
@@ -3738,8 +3616,7 @@ load_root_certificates(ssl::context& ctx, boost::system::error_code& ec)
 		"W9c3rkIO3aQab3yIVMUWbuF6aC74Or8NpDyJO3inTmODBCEIZ43ygknQW/2xzQ+D\n"
 		"hNQ+IIX3Sj0rnP0qCglN6oH4EZw=\n"
 		"-----END CERTIFICATE-----\n"
-		"\n";
-	cert +=
+		"\n"
 		"# emSign ECC Root CA - C3\n"
 		"-----BEGIN CERTIFICATE-----\n"
 		"MIICKzCCAbGgAwIBAgIKe3G2gla4EnycqDAKBggqhkjOPQQDAzBaMQswCQYDVQQG\n"
@@ -3755,8 +3632,7 @@ load_root_certificates(ssl::context& ctx, boost::system::error_code& ec)
 		"3ta13FaPWEBaLd4gTCKDypOofu4SQMfWh0/434UCMBwUZOR8loMRnLDRWmFLpg9J\n"
 		"0wD8ofzkpf9/rdcw0Md3f76BB1UwUCAU9Vc4CqgxUQ==\n"
 		"-----END CERTIFICATE-----\n"
-		"\n";
-	cert +=
+		"\n"
 		"# emSign ECC Root CA - G3\n"
 		"-----BEGIN CERTIFICATE-----\n"
 		"MIICTjCCAdOgAwIBAgIKPPYHqWhwDtqLhDAKBggqhkjOPQQDAzBrMQswCQYDVQQG\n"
@@ -3773,8 +3649,7 @@ load_root_certificates(ssl::context& ctx, boost::system::error_code& ec)
 		"CUfvO6wIBHxcmbHtRwfSAjEAnbpV/KlK6O3t5nYBQnvI+GDZjVGLVTv7jHvrZQnD\n"
 		"+JbNR6iC8hZVdyR+EhCVBCyj\n"
 		"-----END CERTIFICATE-----\n"
-		"\n";
-	cert +=
+		"\n"
 		"# emSign Root CA - C1\n"
 		"-----BEGIN CERTIFICATE-----\n"
 		"MIIDczCCAlugAwIBAgILAK7PALrEzzL4Q7IwDQYJKoZIhvcNAQELBQAwVjELMAkG\n"
@@ -3797,8 +3672,7 @@ load_root_certificates(ssl::context& ctx, boost::system::error_code& ec)
 		"+xHqmiIMERnHXhuBUDDIlhJu58tBf5E7oke3VIAb3ADMmpDqw8NQBmIMMMAVSKeo\n"
 		"WXzhriKi4gp6D/piq1JM4fHfyr6DDUI=\n"
 		"-----END CERTIFICATE-----\n"
-		"\n";
-	cert +=
+		"\n"
 		"# emSign Root CA - G1\n"
 		"-----BEGIN CERTIFICATE-----\n"
 		"MIIDlDCCAnygAwIBAgIKMfXkYgxsWO3W2DANBgkqhkiG9w0BAQsFADBnMQswCQYD\n"
@@ -3822,8 +3696,7 @@ load_root_certificates(ssl::context& ctx, boost::system::error_code& ec)
 		"RQuQ+q7hv53yrlc8pa6yVvSLZUDp/TGBLPQ5Cdjua6e0ph0VpZj3AYHYhX3zUVxx\n"
 		"iN66zB+Afko=\n"
 		"-----END CERTIFICATE-----\n"
-		"\n";
-	cert +=
+		"\n"
 		"# thawte Primary Root CA\n"
 		"-----BEGIN CERTIFICATE-----\n"
 		"MIIEIDCCAwigAwIBAgIQNE7VVyDV7exJ9C/ON9srbTANBgkqhkiG9w0BAQUFADCB\n"
@@ -3850,8 +3723,7 @@ load_root_certificates(ssl::context& ctx, boost::system::error_code& ec)
 		"LHbTY5xZ3Y+m4Q6gLkH3LpVHz7z9M/P2C2F+fpErgUfCJzDupxBdN49cOSvkBPB7\n"
 		"jVaMaA==\n"
 		"-----END CERTIFICATE-----\n"
-		"\n";
-	cert +=
+		"\n"
 		"# thawte Primary Root CA - G2\n"
 		"-----BEGIN CERTIFICATE-----\n"
 		"MIICiDCCAg2gAwIBAgIQNfwmXNmET8k9Jj1Xm67XVjAKBggqhkjOPQQDAzCBhDEL\n"
@@ -3869,8 +3741,7 @@ load_root_certificates(ssl::context& ctx, boost::system::error_code& ec)
 		"KMqh9HneteY4sPBlcIx/AlTCv//YoT7ZzwIxAMSNlPzcU9LcnXgWHxUzI1NS41ox\n"
 		"XZ3Krr0TKUQNJ1uo52icEvdYPy5yAlejj6EULg==\n"
 		"-----END CERTIFICATE-----\n"
-		"\n";
-	cert +=
+		"\n"
 		"# thawte Primary Root CA - G3\n"
 		"-----BEGIN CERTIFICATE-----\n"
 		"MIIEKjCCAxKgAwIBAgIQYAGXt0an6rS0mtZLL/eQ+zANBgkqhkiG9w0BAQsFADCB\n"
@@ -3898,20 +3769,169 @@ load_root_certificates(ssl::context& ctx, boost::system::error_code& ec)
 		"MdRAGmI0Nj81Aa6sY6A=\n"
 		"-----END CERTIFICATE-----";
 
-	ctx.add_certificate_authority(boost::asio::buffer(cert.data(), cert.size()), ec);
+static std::mutex			stores_mtx;
+static std::map<std::string, X509_STORE *>	stores;
+static uint64_t				stores_build_ns;
+
+// Adds every certificate of @pem[0..len) to @store.
+static size_t add_pem_certs(X509_STORE *store, const char *pem, size_t len)
+{
+	BIO *bio = BIO_new_mem_buf(pem, (int)len);
+	size_t n = 0;
+	X509 *x;
+
+	if (!bio)
+		return 0;
+
+	while ((x = PEM_read_bio_X509(bio, nullptr, nullptr, nullptr))) {
+		if (X509_STORE_add_cert(store, x))
+			n++;
+		X509_free(x);
+	}
+
+	ERR_clear_error();
+	BIO_free(bio);
+	return n;
+}
+
+/*
+ * Adds only the bundled certificates whose "# Name" header is listed in
+ * @names. Skipping the others avoids base64 and ASN.1 decoding them.
+ */
+static size_t add_pinned_certs(X509_STORE *store, const std::vector<std::string> &names)
+{
+	static const char end_marker[] = "-----END CERTIFICATE-----";
+	const char *p = root_certs_pem;
+	const char *end = p + sizeof(root_certs_pem) - 1;
+	size_t n = 0;
+
+	while (p < end) {
+		const char *nl, *blk_end;
+
+		if (strncmp(p, "# ", 2)) {
+			p = (const char *)memchr(p, '\n', end - p);
+			if (!p)
+				break;
+			p++;
+			continue;
+		}
+
+		nl = (const char *)memchr(p, '\n', end - p);
+		if (!nl)
+			break;
+
+		blk_end = strstr(nl, end_marker);
+		if (!blk_end)
+			break;
+		blk_end += sizeof(end_marker) - 1;
+
+		std::string name(p + 2, nl - p - 2);
+		if (std::find(names.begin(), names.end(), name) != names.end())
+			n += add_pem_certs(store, nl + 1, blk_end - nl - 1);
+
+		p = blk_end;
+	}
+
+	return n;
+}
+
+static X509_STORE *build_store(WsTrustStore src, const std::vector<std::string> &pinned,
+			       boost::system::error_code &ec)
+{
+	X509_STORE *store = X509_STORE_new();
+	size_t n = 0;
+
+	if (!store) {
+		ec = boost::system::error_code(static_cast<int>(::ERR_get_error()),
+					       boost::asio::error::get_ssl_category());
+		return nullptr;
+	}
+
+	switch (src) {
+	case WsTrustStore::Bundled:
+		n = add_pem_certs(store, root_certs_pem, sizeof(root_certs_pem) - 1);
+		break;
+	case WsTrustStore::System:
+		if (X509_STORE_set_default_paths(store))
+			n = 1;
+		break;
+	case WsTrustStore::Pinned:
+		n = add_pinned_certs(store, pinned);
+		break;
+	}
+
+	if (!n) {
+		X509_STORE_free(store);
+		ec = boost::asio::error::make_error_code(boost::asio::error::invalid_argument);
+		return nullptr;
+	}
+
+	return store;
+}
+
+static std::string store_key(WsTrustStore src, const std::vector<std::string> &pinned)
+{
+	std::string key = std::to_string((int)src);
+
+	if (src == WsTrustStore::Pinned) {
+		for (const auto &name : pinned)
+			key += '\n' + name;
+	}
+
+	return key;
+}
+
+/*
+ * The store of each source is built once per process and shared by
+ * every SSL_CTX through its reference count.
+ */
+static void load_root_certificates(ssl::context &ctx, WsTrustStore src,
+				   const std::vector<std::string> &pinned,
+				   boost::system::error_code &ec)
+{
+	std::lock_guard<std::mutex> lock(stores_mtx);
+	std::string key = store_key(src, pinned);
+	X509_STORE *&store = stores[key];
+
+	if (!store) {
+		auto start = std::chrono::steady_clock::now();
+
+		store = build_store(src, pinned, ec);
+		if (!store) {
+			stores.erase(key);
+			return;
+		}
+
+		stores_build_ns += std::chrono::duration_cast<std::chrono::nanoseconds>(
+			std::chrono::steady_clock::now() - start).count();
+	}
+
+	SSL_CTX_set1_cert_store(ctx.native_handle(), store);
 }
 
 } /* namespace detail */
 
 void load_root_certificates(ssl::context &ctx, boost::system::error_code &ec)
 {
-	detail::load_root_certificates(ctx, ec);
+	detail::load_root_certificates(ctx, WsTrustStore::Bundled, {}, ec);
 }
 
 void load_root_certificates(ssl::context &ctx)
+{
+	load_root_certificates(ctx, WsTrustStore::Bundled);
+}
+
+void load_root_certificates(ssl::context &ctx, WsTrustStore src,
+			    const std::vector<std::string> &pinned)
 {
 	boost::system::error_code ec;
-	detail::load_root_certificates(ctx, ec);
+	detail::load_root_certificates(ctx, src, pinned, ec);
 	if (ec)
 		throw boost::system::system_error{ec};
 }
+
+uint64_t root_store_build_ns(void)
+{
+	std::lock_guard<std::mutex> lock(detail::stores_mtx);
+	return detail::stores_build_ns;
+}
@@ -3,8 +3,17 @@
 #define EXC__ROOTCERTS__HPP
 
 #include <boost/beast/ssl.hpp>
+#include <wbx/exc/WebsocketOpts.hpp>
+#include <cstdint>
+#include <string>
+#include <vector>
 
 void load_root_certificates(boost::asio::ssl::context &ctx, boost::system::error_code &ec);
 void load_root_certificates(boost::asio::ssl::context &ctx);
+void load_root_certificates(boost::asio::ssl::context &ctx, wbx::exc::WsTrustStore src,
+			    const std::vector<std::string> &pinned = {});
+
+// Total time spent building the process-wide trust stores.
+uint64_t root_store_build_ns(void);
 
 #endif /* #ifndef EXC__ROOTCERTS__HPP */
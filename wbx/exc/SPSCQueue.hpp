@@ -0,0 +1,103 @@
+// SPDX-License-Identifier: GPL-2.0-only
+
+#ifndef EXC__SPSC_QUEUE__HPP
+#define EXC__SPSC_QUEUE__HPP
+
+#include <atomic>
+#include <vector>
+#include <cstddef>
+#include <utility>
+
+namespace wbx {
+namespace exc {
+
+/*
+ * Bounded single-producer single-consumer ring buffer.
+ *
+ * push() may only be called from one thread and pop() from one
+ * (other) thread. The capacity is rounded up to a power of two.
+ */
+template<typename T>
+class SPSCQueue {
+private:
+	std::vector<T>	buf_;
+	size_t		mask_;
+
+	alignas(64) std::atomic<size_t>	head_;
+	size_t				tail_cache_;
+
+	alignas(64) std::atomic<size_t>	tail_;
+	size_t				head_cache_;
+
+	static inline size_t roundPow2(size_t n)
+	{
+		size_t r = 2;
+
+		while (r < n)
+			r <<= 1;
+
+		return r;
+	}
+
+public:
+	inline explicit SPSCQueue(size_t cap = 4096):
+		buf_(roundPow2(cap)),
+		mask_(buf_.size() - 1),
+		head_(0),
+		tail_cache_(0),
+		tail_(0),
+		head_cache_(0)
+	{
+	}
+
+	// Producer side. @v is left untouched when the queue is full.
+	inline bool push(T &&v)
+	{
+		size_t tail = tail_.load(std::memory_order_relaxed);
+
+		if (tail - head_cache_ > mask_) {
+			head_cache_ = head_.load(std::memory_order_acquire);
+			if (tail - head_cache_ > mask_)
+				return false;
+		}
+
+		buf_[tail & mask_] = std::move(v);
+		tail_.store(tail + 1, std::memory_order_release);
+		return true;
+	}
+
+	// Consumer side.
+	inline bool pop(T &v)
+	{
+		size_t head = head_.load(std::memory_order_relaxed);
+
+		if (head == tail_cache_) {
+			tail_cache_ = tail_.load(std::memory_order_acquire);
+			if (head == tail_cache_)
+				return false;
+		}
+
+		v = std::move(buf_[head & mask_]);
+		head_.store(head + 1, std::memory_order_release);
+		return true;
+	}
+
+	inline bool empty(void) const
+	{
+		return head_.load(std::memory_order_acquire) ==
+		       tail_.load(std::memory_order_acquire);
+	}
+
+	inline size_t size(void) const
+	{
+		return tail_.load(std::memory_order_acquire) -
+		       head_.load(std::memory_order_acquire);
+	}
+
+	inline size_t capacity(void) const { return buf_.size(); }
+};
+
+} /* namespace exc */
+} /* namespace wbx */
+
+#endif /* #ifndef EXC__SPSC_QUEUE__HPP */
@@ -0,0 +1,83 @@
+// SPDX-License-Identifier: GPL-2.0-only
+
+#ifndef EXC__TOKEN_BUCKET__HPP
+#define EXC__TOKEN_BUCKET__HPP
+
+#include <cstdint>
+
+namespace wbx {
+namespace exc {
+
+/*
+ * Rate limiter: @burst tokens, refilled at @rate_per_s. Time is passed
+ * in by the caller (steady clock nanoseconds). Not thread-safe.
+ */
+class TokenBucket {
+private:
+	double		rate_per_ns_ = 0;
+	double		burst_ = 0;
+	double		tokens_ = 0;
+	uint64_t	last_ns_ = 0;
+
+	inline void refill(uint64_t now_ns) noexcept
+	{
+		if (now_ns > last_ns_) {
+			tokens_ += (double)(now_ns - last_ns_) * rate_per_ns_;
+			if (tokens_ > burst_)
+				tokens_ = burst_;
+		}
+		last_ns_ = now_ns;
+	}
+
+public:
+	inline TokenBucket(double rate_per_s = 1, double burst = 1) noexcept
+	{
+		setRate(rate_per_s, burst);
+	}
+
+	// Starts full.
+	inline void setRate(double rate_per_s, double burst) noexcept
+	{
+		rate_per_ns_ = rate_per_s / 1e9;
+		burst_ = burst;
+		tokens_ = burst;
+		last_ns_ = 0;
+	}
+
+	inline bool take(uint64_t now_ns) noexcept
+	{
+		if (!last_ns_)
+			last_ns_ = now_ns;
+
+		refill(now_ns);
+		if (tokens_ < 1)
+			return false;
+
+		tokens_ -= 1;
+		return true;
+	}
+
+	// Return a token from take() that was not used after all.
+	inline void giveBack(void) noexcept
+	{
+		tokens_ = (tokens_ + 1 < burst_) ? tokens_ + 1 : burst_;
+	}
+
+	// Time until take() succeeds, 0 if it would now.
+	inline uint64_t waitNs(uint64_t now_ns) noexcept
+	{
+		if (!last_ns_)
+			return 0;
+
+		refill(now_ns);
+		if (tokens_ >= 1)
+			return 0;
+
+		return (uint64_t)((1 - tokens_) / rate_per_ns_) + 1;
+	}
+};
+
+} /* namespace exc */
+} /* namespace wbx */
+
+#endif /* #ifndef EXC__TOKEN_BUCKET__HPP */
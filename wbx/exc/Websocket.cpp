@@ -4,6 +4,8 @@
 #include <wbx/exc/Websocket.hpp>
 #include <wbx/exc/RootCerts.hpp>
 
+#include <algorithm>
+
 namespace wbx {
 namespace exc {
 
@@ -13,107 +15,443 @@ WebsocketSession::WebsocketSession(Websocket *ws, const std::string &host,
 {
 	ws_sess_shr_ = new std::shared_ptr<WebsocketImplSession>();
 	*ws_sess_shr_ = std::make_shared<WebsocketImplSession>(ws->getIOCtx(),
-							       ws->getSSLCtx());
+							       ws->getTlsCtxRef(),
+							       ws->getResolverRef());
+
+	standby_shr_ = new std::shared_ptr<WebsocketImplSession>();
+	alive_ = std::make_shared<bool>(true);
 
 	ws_sess_ = ws_sess_shr_->get();
 	ws_sess_->setHost(host);
 	ws_sess_->setPort(port);
 	ws_sess_->setUri(uri);
-	ws_sess_->setUData(this);
+	attachCallbacks();
 }
 
-void WebsocketSession::setOnConnect(WsOnConnect_t onConnect)
+/*
+ * The primary connection. Failovers and reconnects replace it on the io
+ * thread, so callers elsewhere hold their own reference while they use
+ * it.
+ */
+std::shared_ptr<WebsocketImplSession> WebsocketSession::primary(void) const
+{
+	std::lock_guard<lp_mutex_t> lock(sess_mtx_);
+	return *ws_sess_shr_;
+}
+
+size_t WebsocketSession::callOnRead(WebsocketSession *ws_sess, const char *data,
+				    size_t len)
+{
+	return onRead_(ws_sess, data, len);
+}
+
+size_t WebsocketSession::discardRead(WebsocketSession *ws_sess, const char *data,
+				     size_t len)
+{
+	(void)ws_sess;
+	(void)data;
+	return len;
+}
+
+/*
+ * Point the primary connection at the callbacks of this session. The
+ * wrappers look the callbacks up on every call, so they survive the
+ * primary being replaced by the standby.
+ */
+void WebsocketSession::attachCallbacks(void)
 {
-	ws_sess_->setOnConnect([ocf=std::move(onConnect)](
-				WebsocketImplSession *ws_sess,
+	ws_sess_->setUData(this);
+	ws_sess_->setOnRead(onReadRef_);
+
+	ws_sess_->setOnConnect([](WebsocketImplSession *ws_sess, void *udata) {
+		WebsocketSession *ws = static_cast<WebsocketSession *>(udata);
+
+		if (ws->reconnect_) {
+			std::lock_guard<lp_mutex_t> lock(ws->sess_mtx_);
+			ws->reconnect_backoff_ms_ = 0;
+		}
+
+		if (ws->onConnect_)
+			ws->onConnect_(ws);
+		(void)ws_sess;
+	});
+
+	ws_sess_->setOnWrite([](WebsocketImplSession *ws_sess, size_t len,
 				void *udata) {
 		WebsocketSession *ws = static_cast<WebsocketSession *>(udata);
-		ocf(ws);
+
+		if (ws->onWrite_)
+			ws->onWrite_(ws, len);
 		(void)ws_sess;
 	});
-}
 
-void WebsocketSession::setOnRead(WsOnRead_t onRead)
-{
-	ws_sess_->setOnRead([orf=std::move(onRead)](
-				WebsocketImplSession *ws_sess,
-				const char *data,
-				size_t len, void *udata) {
+	ws_sess_->setOnClose([](WebsocketImplSession *ws_sess, void *udata) {
 		WebsocketSession *ws = static_cast<WebsocketSession *>(udata);
+
+		if (ws->onClose_)
+			ws->onClose_(ws);
 		(void)ws_sess;
-		return orf(ws, data, len);
 	});
+
+	ws_sess_->setOnConnErr([](WebsocketImplSession *ws_sess, int code,
+				  const char *msg, void *udata) {
+		WebsocketSession *ws = static_cast<WebsocketSession *>(udata);
+
+		if (ws->failover(ws_sess))
+			return;
+		if (ws->onConnErr_)
+			ws->onConnErr_(ws, code, msg);
+		ws->maybeReconnect(ws_sess);
+	});
+}
+
+void WebsocketSession::setOnConnect(WsOnConnect_t onConnect)
+{
+	onConnect_ = std::move(onConnect);
+}
+
+void WebsocketSession::setOnRead(WsOnRead_t onRead)
+{
+	onRead_ = std::move(onRead);
+	onReadRef_ = WsOnReadRef_t::bind<&WebsocketSession::callOnRead>(this);
+	primary()->setOnRead(onReadRef_);
+}
+
+void WebsocketSession::setOnRead(WsOnReadRef_t onRead)
+{
+	onRead_ = nullptr;
+	onReadRef_ = onRead;
+	primary()->setOnRead(onReadRef_);
 }
 
 void WebsocketSession::setOnWrite(WsOnWrite_t onWrite)
 {
-	ws_sess_->setOnWrite([owf=std::move(onWrite)](
-				WebsocketImplSession *ws_sess, size_t len,
-				void *udata) {
-		WebsocketSession *ws = static_cast<WebsocketSession *>(udata);
-		owf(ws, len);
-		(void)ws_sess;
-	});
+	onWrite_ = std::move(onWrite);
 }
 
 void WebsocketSession::setOnClose(WsOnClose_t onClose)
 {
-	ws_sess_->setOnClose([ocf=std::move(onClose)](
-					WebsocketImplSession *ws_sess,
-					void *udata) {
-		WebsocketSession *ws = static_cast<WebsocketSession *>(udata);
-		ocf(ws);
-		(void)ws_sess;
-	});
+	onClose_ = std::move(onClose);
 }
 
 void WebsocketSession::setOnConnErr(WsOnConnErr_t onConnErr)
 {
-	ws_sess_->setOnConnErr([ocef=std::move(onConnErr)](
-					WebsocketImplSession *ws_sess, int code,
-					const char *msg, void *udata) {
+	onConnErr_ = std::move(onConnErr);
+}
+
+void WebsocketSession::setStandby(bool enable, uint64_t keepalive_ms)
+{
+	std::lock_guard<lp_mutex_t> lock(sess_mtx_);
+
+	standby_ = enable;
+	standby_keepalive_ms_ = keepalive_ms;
+}
+
+bool WebsocketSession::isStandbyReady(void) const
+{
+	std::lock_guard<lp_mutex_t> lock(sess_mtx_);
+	return standby_ready_;
+}
+
+uint64_t WebsocketSession::getNrFailovers(void) const
+{
+	std::lock_guard<lp_mutex_t> lock(sess_mtx_);
+	return nr_failovers_;
+}
+
+void WebsocketSession::buildStandby(void)
+{
+	std::shared_ptr<WebsocketImplSession> sb;
+
+	sb = std::make_shared<WebsocketImplSession>(ws_->getIOCtx(),
+						    ws_->getTlsCtxRef(),
+						    ws_->getResolverRef());
+	{
+		std::lock_guard<lp_mutex_t> lock(sess_mtx_);
+
+		if (!standby_ || *standby_shr_)
+			return;
+
+		sb->copySettings(*ws_sess_);
+		*standby_shr_ = sb;
+		standby_ready_ = false;
+	}
+
+	sb->setUData(this);
+	// Dead standbys are caught by the heartbeat too, their pongs
+	// just do not count towards the primary's RTT.
+	sb->setHeartbeat(hb_, nullptr);
+	sb->setAutoRead(true);
+	sb->setKeepAlive(standby_keepalive_ms_);
+	sb->setOnRead(WsOnReadRef_t::bind<&WebsocketSession::discardRead>(this));
+
+	sb->setOnConnect([](WebsocketImplSession *ws_sess, void *udata) {
+		WebsocketSession *ws = static_cast<WebsocketSession *>(udata);
+		std::lock_guard<lp_mutex_t> lock(ws->sess_mtx_);
+
+		if (ws->standby_shr_->get() == ws_sess)
+			ws->standby_ready_ = true;
+	});
+
+	sb->setOnConnErr([](WebsocketImplSession *ws_sess, int code,
+			    const char *msg, void *udata) {
 		WebsocketSession *ws = static_cast<WebsocketSession *>(udata);
-		ocef(ws, code, msg);
+		std::shared_ptr<WebsocketImplSession> dead;
+
+		{
+			std::lock_guard<lp_mutex_t> lock(ws->sess_mtx_);
+
+			if (ws->standby_shr_->get() != ws_sess)
+				return;
+
+			dead = std::move(*ws->standby_shr_);
+			ws->standby_shr_->reset();
+			ws->standby_ready_ = false;
+		}
+
+		dead->close();
+		ws->scheduleStandby(1000);
+		(void)code;
+		(void)msg;
+	});
+
+	sb->run();
+}
+
+void WebsocketSession::scheduleStandby(uint64_t delay_ms)
+{
+	std::weak_ptr<bool> alive = alive_;
+
+	ws_->runAfter(delay_ms, [this, alive]() {
+		if (alive.lock())
+			buildStandby();
+	});
+}
+
+/*
+ * Called with the connection that reported an error. If it is the
+ * primary and a standby is ready, the standby becomes the primary and
+ * the error is not reported.
+ */
+bool WebsocketSession::failover(const void *failed)
+{
+	std::shared_ptr<WebsocketImplSession> old;
+
+	{
+		std::lock_guard<lp_mutex_t> lock(sess_mtx_);
+
+		if (!standby_ || failed != ws_sess_ || !standby_ready_)
+			return false;
+
+		old = std::move(*ws_sess_shr_);
+		*ws_sess_shr_ = std::move(*standby_shr_);
+		standby_shr_->reset();
+		ws_sess_ = ws_sess_shr_->get();
+		standby_ready_ = false;
+		nr_failovers_++;
+		sess_gen_++;
+	}
+
+	old->close();
+	ws_sess_->promote([this]() {
+		ws_sess_->setHeartbeat(hb_, &hb_rtt_);
+		attachCallbacks();
+		if (onConnect_)
+			onConnect_(this);
+	});
+
+	scheduleStandby(0);
+	return true;
+}
+
+void WebsocketSession::setHeartbeat(const WsHeartbeatOpts &opts)
+{
+	hb_ = opts;
+	primary()->setHeartbeat(hb_, &hb_rtt_);
+}
+
+void WebsocketSession::setReconnect(bool enable, uint64_t max_backoff_ms)
+{
+	std::lock_guard<lp_mutex_t> lock(sess_mtx_);
+
+	reconnect_ = enable;
+	reconnect_max_ms_ = max_backoff_ms;
+	reconnect_backoff_ms_ = 0;
+}
+
+uint64_t WebsocketSession::getNrReconnects(void) const
+{
+	std::lock_guard<lp_mutex_t> lock(sess_mtx_);
+	return nr_reconnects_;
+}
+
+void WebsocketSession::reconnect(void)
+{
+	std::shared_ptr<WebsocketImplSession> sess, old;
+
+	sess = std::make_shared<WebsocketImplSession>(ws_->getIOCtx(),
+						      ws_->getTlsCtxRef(),
+						      ws_->getResolverRef());
+	{
+		std::lock_guard<lp_mutex_t> lock(sess_mtx_);
+
+		sess->copySettings(*ws_sess_);
+		old = std::move(*ws_sess_shr_);
+		*ws_sess_shr_ = sess;
+		ws_sess_ = sess.get();
+		nr_reconnects_++;
+		sess_gen_++;
+	}
+
+	attachCallbacks();
+	old->close();
+	sess->run();
+}
+
+/*
+ * Called after the primary @failed reported an error that no standby
+ * could absorb.
+ */
+void WebsocketSession::maybeReconnect(const void *failed)
+{
+	std::weak_ptr<bool> alive = alive_;
+	uint64_t delay, gen;
+
+	{
+		std::lock_guard<lp_mutex_t> lock(sess_mtx_);
+
+		if (!reconnect_ || failed != ws_sess_)
+			return;
+
+		gen = sess_gen_;
+		delay = reconnect_backoff_ms_;
+		reconnect_backoff_ms_ = std::min(delay ? delay * 2 : 100,
+						 reconnect_max_ms_);
+	}
+
+	ws_->runAfter(delay, [this, alive, gen]() {
+		if (!alive.lock())
+			return;
+
+		// Replaced meanwhile, by a failover or another reconnect.
+		{
+			std::lock_guard<lp_mutex_t> lock(sess_mtx_);
+			if (!reconnect_ || gen != sess_gen_)
+				return;
+		}
+
+		reconnect();
 	});
 }
 
 void WebsocketSession::setHost(const std::string &host)
 {
-	ws_sess_->setHost(host);
+	primary()->setHost(host);
 }
 
 void WebsocketSession::setPort(uint16_t port)
 {
-	ws_sess_->setPort(port);
+	primary()->setPort(port);
 }
 
 void WebsocketSession::setUri(const std::string &uri)
 {
-	ws_sess_->setUri(uri);
+	primary()->setUri(uri);
+}
+
+void WebsocketSession::setSockOpts(const WsSockOpts &opts)
+{
+	if (opts.write_buffer_bytes >= 0 && opts.write_buffer_bytes < 8)
+		throw std::invalid_argument("write_buffer_bytes must be at least 8");
+
+	primary()->setSockOpts(opts);
+}
+
+WsTlsInfo WebsocketSession::getTlsInfo(void) const
+{
+	return primary()->getTlsInfo();
+}
+
+WsSockOpts WebsocketSession::getEffectiveSockOpts(void) const
+{
+	return primary()->getEffectiveSockOpts();
+}
+
+void WebsocketSession::setBusyPoll(unsigned usec)
+{
+	primary()->setBusyPoll(usec);
 }
 
 void WebsocketSession::setUserAgent(const std::string &userAgent)
 {
-	ws_sess_->setUserAgent(userAgent);
+	primary()->setUserAgent(userAgent);
+}
+
+int WebsocketSession::__write(const char *data, size_t len, const WsMsgMeta *meta)
+{
+	return primary()->write(data, len, meta);
+}
+
+int WebsocketSession::write(const char *data, size_t len)
+{
+	return __write(data, len, nullptr);
+}
+
+int WebsocketSession::write(const char *data, size_t len, const WsMsgMeta &meta)
+{
+	return __write(data, len, &meta);
+}
+
+void WebsocketSession::setQueueOpts(const WsQueueOpts &opts)
+{
+	primary()->setQueueOpts(opts);
 }
 
-void WebsocketSession::write(const char *data, size_t len)
+WsQueueStats WebsocketSession::getQueueStats(void) const
 {
-	ws_sess_->write(data, len);
+	return primary()->getQueueStats();
 }
 
 void WebsocketSession::read(void)
 {
-	ws_sess_->readAfter();
+	primary()->readAfter();
 }
 
 void WebsocketSession::run(void)
 {
-	ws_sess_->run();
+	primary()->run();
+	if (standby_)
+		buildStandby();
+}
+
+void WebsocketSession::close(void)
+{
+	std::shared_ptr<WebsocketImplSession> cur, sb;
+
+	{
+		std::lock_guard<lp_mutex_t> lock(sess_mtx_);
+
+		standby_ = false;
+		standby_ready_ = false;
+		reconnect_ = false;
+		cur = *ws_sess_shr_;
+		sb = std::move(*standby_shr_);
+		standby_shr_->reset();
+	}
+
+	if (sb)
+		sb->close();
+	cur->close();
+}
+
+HandlerAllocStats WebsocketSession::getHandlerAllocStats(void) const
+{
+	return primary()->getHandlerAllocStats();
 }
 
 WebsocketSession::~WebsocketSession(void)
 {
+	delete standby_shr_;
 	delete ws_sess_shr_;
 }
 
@@ -122,6 +460,42 @@ Websocket::Websocket(void):
 {
 }
 
+Websocket::Websocket(std::shared_ptr<WebsocketTlsCtx> tls_ctx):
+	ws_(new WebsocketImpl(std::move(tls_ctx)))
+{
+}
+
+std::shared_ptr<WebsocketTlsCtx> Websocket::getTlsCtx(void)
+{
+	return ws_->getTlsCtx();
+}
+
+uint64_t Websocket::getTrustStoreLoadNs(void)
+{
+	return ws_->getTlsCtx()->getTrustStoreLoadNs();
+}
+
+void Websocket::setDnsOpts(const WsDnsOpts &opts)
+{
+	ws_->getResolver().setOpts(opts);
+}
+
+void Websocket::preResolve(const std::string &host, uint16_t port)
+{
+	ws_->getResolver().preResolve(host, port);
+}
+
+WsDnsStats Websocket::getDnsStats(void)
+{
+	return ws_->getResolver().getStats();
+}
+
+// static
+std::shared_ptr<WebsocketTlsCtx> Websocket::createTlsCtx(const WsTlsOpts &opts)
+{
+	return std::make_shared<WebsocketTlsCtx>(opts);
+}
+
 Websocket::~Websocket(void)
 {
 	if (ws_thread_)
@@ -138,10 +512,43 @@ WebsocketSession *Websocket::createSession(const std::string &host,
 
 	ws_sess = std::make_unique<WebsocketSession>(this, host, port, uri);
 	WebsocketSession *ws_sess_ptr = ws_sess.get();
+
+	std::lock_guard<lp_mutex_t> lock(sessions_mtx_);
 	ws_sessions_.push_back(std::move(ws_sess));
 	return ws_sess_ptr;
 }
 
+void Websocket::destroySession(WebsocketSession *ws_sess)
+{
+	ws_sess->close();
+	ws_sess->primary()->close([this, ws_sess]() {
+		std::lock_guard<lp_mutex_t> lock(sessions_mtx_);
+
+		for (auto it = ws_sessions_.begin(); it != ws_sessions_.end(); it++) {
+			if (it->get() == ws_sess) {
+				ws_sessions_.erase(it);
+				break;
+			}
+		}
+	});
+}
+
+void Websocket::post(std::function<void(void)> fn)
+{
+	net::post(ws_->getIOCtx(), std::move(fn));
+}
+
+void Websocket::runAfter(uint64_t ms, std::function<void(void)> fn)
+{
+	auto timer = std::make_shared<net::steady_timer>(ws_->getIOCtx(),
+							 std::chrono::milliseconds(ms));
+
+	timer->async_wait([timer, fn = std::move(fn)](const beast::error_code &ec) {
+		if (!ec)
+			fn();
+	});
+}
+
 void Websocket::run(void)
 {
 	ws_->run();
@@ -154,5 +561,23 @@ void Websocket::bgRun(void)
 	});
 }
 
+void Websocket::run(const WsRunOpts &opts)
+{
+	if (opts.cpu >= 0)
+		WebsocketImpl::pinThisThread(opts.cpu);
+
+	if (opts.busy_poll)
+		ws_->runBusyPoll(opts.spin_idle_ns);
+	else
+		ws_->run();
+}
+
+void Websocket::bgRun(const WsRunOpts &opts)
+{
+	ws_thread_ = std::make_unique<std::thread>([this, opts]() {
+		run(opts);
+	});
+}
+
 } /* namespace exc */
 } /* namespace wbx */
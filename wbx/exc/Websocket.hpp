@@ -4,11 +4,17 @@
 #define EXC__WEBSOCKET__HPP
 
 #include <thread>
+#include <atomic>
 #include <vector>
 #include <memory>
 #include <string>
 #include <cstdint>
 #include <functional>
+#include <wbx/exc/FuncRef.hpp>
+#include <wbx/exc/Histogram.hpp>
+#include <wbx/exc/LockPolicy.hpp>
+#include <wbx/exc/HandlerAlloc.hpp>
+#include <wbx/exc/WebsocketOpts.hpp>
 #include <wbx/exc/WebsocketImpl.hpp>
 
 /*
@@ -20,23 +26,65 @@ namespace exc {
 
 class WebsocketSession;
 class Websocket;
+class WebsocketTlsCtx;
+class WebsocketImplSession;
 
 typedef std::function<void(WebsocketSession *ws_sess)> WsOnConnect_t;
 typedef std::function<size_t(WebsocketSession *ws_sess, const char *data, size_t len)> WsOnRead_t;
+typedef FuncRef<size_t(WebsocketSession *ws_sess, const char *data, size_t len)> WsOnReadRef_t;
 typedef std::function<void(WebsocketSession *ws_sess, size_t len)> WsOnWrite_t;
 typedef std::function<void(WebsocketSession *ws_sess)> WsOnClose_t;
 typedef std::function<void(WebsocketSession *ws_sess, int code, const char *msg)> WsOnConnErr_t;
 
 class WebsocketSession {
 private:
+	friend class Websocket;
+
 #ifdef EXC_USE_WEBSOCKET_IMPL
 	WebsocketImplSession			*ws_sess_ = nullptr;
 	std::shared_ptr<WebsocketImplSession>	*ws_sess_shr_ = nullptr;
+	std::shared_ptr<WebsocketImplSession>	*standby_shr_ = nullptr;
 #else
 	void					*ws_sess_ = nullptr;
 	void					*ws_sess_shr_ = nullptr;
+	void					*standby_shr_ = nullptr;
 #endif
 	Websocket	*ws_;
+	WsOnRead_t	onRead_ = nullptr;
+	WsOnReadRef_t	onReadRef_;
+	WsOnConnect_t	onConnect_ = nullptr;
+	WsOnWrite_t	onWrite_ = nullptr;
+	WsOnClose_t	onClose_ = nullptr;
+	WsOnConnErr_t	onConnErr_ = nullptr;
+
+	// Guards the primary / standby pointers once the standby is on.
+	mutable lp_mutex_t	sess_mtx_;
+	std::atomic<bool>	standby_{false};
+	bool			standby_ready_ = false;
+	uint64_t		standby_keepalive_ms_ = 0;
+	uint64_t		nr_failovers_ = 0;
+	std::atomic<bool>	reconnect_{false};
+	uint64_t		reconnect_max_ms_ = 0;
+	// Delay of the next reconnect attempt, reset by a handshake.
+	uint64_t		reconnect_backoff_ms_ = 0;
+	uint64_t		nr_reconnects_ = 0;
+	// Bumped whenever the primary is replaced. Deferred reconnects
+	// compare it, a freed primary's address may be reused.
+	uint64_t		sess_gen_ = 0;
+	WsHeartbeatOpts		hb_;
+	LatencyHistogram	hb_rtt_;
+	// Expires with the session, checked by deferred standby rebuilds.
+	std::shared_ptr<bool>	alive_;
+
+	std::shared_ptr<WebsocketImplSession> primary(void) const;
+	size_t callOnRead(WebsocketSession *ws_sess, const char *data, size_t len);
+	size_t discardRead(WebsocketSession *ws_sess, const char *data, size_t len);
+	void attachCallbacks(void);
+	void buildStandby(void);
+	void scheduleStandby(uint64_t delay_ms);
+	bool failover(const void *failed);
+	int __write(const char *data, size_t len, const WsMsgMeta *meta);
+	void maybeReconnect(const void *failed);
 
 public:
 	WebsocketSession(Websocket *ws, const std::string &host = "",
@@ -50,14 +98,87 @@ public:
 
 	void setOnConnect(WsOnConnect_t onConnect);
 	void setOnRead(WsOnRead_t onRead);
+
+	/*
+	 * Statically dispatched read handler, e.g.
+	 * WsOnReadRef_t::bind<&Foo::onRead>(foo). The frame goes straight
+	 * from the session to the handler through a single thunk call.
+	 */
+	void setOnRead(WsOnReadRef_t onRead);
 	void setOnWrite(WsOnWrite_t onWrite);
 	void setOnClose(WsOnClose_t onClose);
 	void setOnConnErr(WsOnConnErr_t onConnErr);
 
-	void write(const char *data, size_t len);
-	inline void write(const std::string &data) { write(data.c_str(), data.size()); }
+	/*
+	 * Queue @data for sending. Returns 0, or -ENOBUFS when the queue
+	 * policy of the message class refused it, see setQueueOpts().
+	 */
+	int write(const char *data, size_t len);
+	int write(const char *data, size_t len, const WsMsgMeta &meta);
+	inline int write(const std::string &data) { return write(data.c_str(), data.size()); }
+	inline int write(const std::string &data, const WsMsgMeta &meta)
+	{
+		return write(data.c_str(), data.size(), meta);
+	}
+
+	// Bound of the outbound queue. Call before run(), kept across
+	// reconnects and failovers.
+	void setQueueOpts(const WsQueueOpts &opts);
+	// Outbound queue of the current connection.
+	WsQueueStats getQueueStats(void) const;
 	void read(void);
 	void run(void);
+
+	// Drop the connection. No callback is invoked afterwards.
+	void close(void);
+
+	/*
+	 * Keep a second, handshaked connection to the same endpoint that
+	 * carries no traffic besides websocket pings every @keepalive_ms.
+	 * When the primary fails the standby takes its place right away:
+	 * onConnect fires again so subscriptions can be replayed, and a
+	 * new standby is built in the background. Call before run().
+	 */
+	void setStandby(bool enable, uint64_t keepalive_ms = 10000);
+	bool isStandbyReady(void) const;
+	uint64_t getNrFailovers(void) const;
+
+	/*
+	 * Send @opts.ping when the connection has been silent for
+	 * @opts.interval_ms and treat it as dead (onConnErr with a timeout)
+	 * when nothing arrives within @opts.timeout_ms after that. Pongs are
+	 * consumed here and their round trip recorded in getHeartbeatRtt().
+	 * Call before run().
+	 */
+	void setHeartbeat(const WsHeartbeatOpts &opts);
+	const LatencyHistogram &getHeartbeatRtt(void) const { return hb_rtt_; }
+
+	/*
+	 * Replace the connection with a fresh one after an error. onConnErr
+	 * still fires; the first retry is immediate, then the delay doubles
+	 * from 100 ms up to @max_backoff_ms until a handshake succeeds.
+	 * onConnect fires again on every new connection.
+	 */
+	void setReconnect(bool enable, uint64_t max_backoff_ms = 5000);
+
+	// Drop the current connection and connect again. io thread only.
+	void reconnect(void);
+	uint64_t getNrReconnects(void) const;
+
+	// TLS parameters negotiated by the last handshake.
+	WsTlsInfo getTlsInfo(void) const;
+
+	// Applied on the next connect. Throws on invalid values.
+	void setSockOpts(const WsSockOpts &opts);
+	// Values read back from the socket / stream after the last connect.
+	WsSockOpts getEffectiveSockOpts(void) const;
+
+	// Shorthand for WsSockOpts::busy_poll_us. Raising it above
+	// net.core.busy_read needs CAP_NET_ADMIN.
+	void setBusyPoll(unsigned usec);
+
+	// Async operation memory taken from the session arena vs the heap.
+	HandlerAllocStats getHandlerAllocStats(void) const;
 };
 
 class Websocket {
@@ -67,24 +188,56 @@ private:
 #else
 	void		*ws_;
 #endif
+	lp_mutex_t	sessions_mtx_;
 	std::vector<std::unique_ptr<WebsocketSession>> ws_sessions_;
 	std::unique_ptr<std::thread> ws_thread_;
 
 public:
 	Websocket(void);
+	// Share the TLS context (and its session cache) of another instance.
+	explicit Websocket(std::shared_ptr<WebsocketTlsCtx> tls_ctx);
 	~Websocket(void);
 
+	std::shared_ptr<WebsocketTlsCtx> getTlsCtx(void);
+	uint64_t getTrustStoreLoadNs(void);
+
+	static std::shared_ptr<WebsocketTlsCtx> createTlsCtx(const WsTlsOpts &opts);
+
+	void setDnsOpts(const WsDnsOpts &opts);
+
+	/*
+	 * Resolve @host:@port into the resolver cache ahead of the first
+	 * connect. Takes effect once run() / bgRun() drives the io_context.
+	 */
+	void preResolve(const std::string &host, uint16_t port);
+	WsDnsStats getDnsStats(void);
+
 #ifdef EXC_USE_WEBSOCKET_IMPL
 	inline net::io_context &getIOCtx(void) { return ws_->getIOCtx(); }
 	inline ssl::context &getSSLCtx(void) { return ws_->getSSLCtx(); }
+	inline WebsocketTlsCtx &getTlsCtxRef(void) { return *ws_->getTlsCtx(); }
+	inline WsResolverCache &getResolverRef(void) { return ws_->getResolver(); }
 #endif
 
 	void run(void);
 	void bgRun(void);
+	void run(const WsRunOpts &opts);
+	void bgRun(const WsRunOpts &opts);
 
 	WebsocketSession *createSession(const std::string &host = "",
 					uint16_t port = 8443,
 					const std::string &uri = "/");
+
+	/*
+	 * Close @ws_sess and free it on the io thread. The pointer must
+	 * not be used after this call.
+	 */
+	void destroySession(WebsocketSession *ws_sess);
+
+	// Run @fn on the io thread.
+	void post(std::function<void(void)> fn);
+	// Run @fn on the io thread after @ms milliseconds.
+	void runAfter(uint64_t ms, std::function<void(void)> fn);
 };
 
 } /* namespace exc */
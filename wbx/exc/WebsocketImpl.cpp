@@ -4,67 +4,541 @@
 #undef EXC_USE_WEBSOCKET_IMPL
 
 #include <cstdio>
+#include <chrono>
+#include <cerrno>
+#include <cstring>
+#include <algorithm>
 #include <wbx/exc/RootCerts.hpp>
 
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#endif
+
 namespace wbx {
 namespace exc {
 
+static inline uint64_t nowNs(void)
+{
+	return std::chrono::duration_cast<std::chrono::nanoseconds>(
+		std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+WebsocketTlsCtx::WebsocketTlsCtx(const WsTlsOpts &opts):
+	ctx_(ssl::context::tls_client)
+{
+	SSL_CTX *c = ctx_.native_handle();
+	auto start = std::chrono::steady_clock::now();
+
+	SSL_CTX_set_min_proto_version(c, TLS1_2_VERSION);
+	SSL_CTX_set_ciphersuites(c, "TLS_AES_128_GCM_SHA256:"
+				    "TLS_CHACHA20_POLY1305_SHA256:"
+				    "TLS_AES_256_GCM_SHA384");
+	SSL_CTX_set_cipher_list(c, "ECDHE-ECDSA-AES128-GCM-SHA256:"
+				   "ECDHE-RSA-AES128-GCM-SHA256:"
+				   "ECDHE-ECDSA-CHACHA20-POLY1305:"
+				   "ECDHE-RSA-CHACHA20-POLY1305:"
+				   "ECDHE-ECDSA-AES256-GCM-SHA384:"
+				   "ECDHE-RSA-AES256-GCM-SHA384");
+	SSL_CTX_set1_groups_list(c, "X25519:P-256");
+
+	SSL_CTX_set_session_cache_mode(c, SSL_SESS_CACHE_CLIENT |
+					  SSL_SESS_CACHE_NO_INTERNAL_STORE);
+	SSL_CTX_sess_set_new_cb(c, &WebsocketTlsCtx::newSessionCb);
+
+	load_root_certificates(ctx_, opts.trust_store, opts.pinned_cas);
+	ctx_.set_verify_mode(opts.verify ? ssl::verify_peer : ssl::verify_none);
+	trust_store_load_ns_ = std::chrono::duration_cast<std::chrono::nanoseconds>(
+		std::chrono::steady_clock::now() - start).count();
+}
+
+WebsocketTlsCtx::~WebsocketTlsCtx(void)
+{
+	for (auto &it : cache_)
+		SSL_SESSION_free(it.second);
+}
+
+// static
+int WebsocketTlsCtx::getSessionExIdx(void)
+{
+	static const int idx = SSL_get_ex_new_index(0, nullptr, nullptr,
+						    nullptr, nullptr);
+	return idx;
+}
+
+// static
+int WebsocketTlsCtx::newSessionCb(SSL *ssl, SSL_SESSION *sess)
+{
+	WebsocketImplSession *ws_sess;
+
+	ws_sess = static_cast<WebsocketImplSession *>(
+			SSL_get_ex_data(ssl, getSessionExIdx()));
+	if (!ws_sess)
+		return 0;
+
+	// Taking ownership of the reference OpenSSL handed us.
+	ws_sess->getTlsCtx()->putSession(ws_sess->getTlsSessionKey(), sess);
+	return 1;
+}
+
+SSL_SESSION *WebsocketTlsCtx::getSession(const std::string &key)
+{
+	std::lock_guard<lp_mutex_t> lock(cache_mtx_);
+	auto it = cache_.find(key);
+
+	if (it == cache_.end())
+		return nullptr;
+
+	SSL_SESSION_up_ref(it->second);
+	return it->second;
+}
+
+void WebsocketTlsCtx::putSession(const std::string &key, SSL_SESSION *sess)
+{
+	std::lock_guard<lp_mutex_t> lock(cache_mtx_);
+	SSL_SESSION *&slot = cache_[key];
+
+	if (slot)
+		SSL_SESSION_free(slot);
+
+	slot = sess;
+}
+
+WsResolverCache::WsResolverCache(net::io_context &ioc):
+	resolver_(ioc),
+	nr_hits_(0),
+	nr_misses_(0),
+	nr_refreshes_(0),
+	nr_errors_(0)
+{
+}
+
+void WsResolverCache::setOpts(const WsDnsOpts &opts)
+{
+	std::lock_guard<lp_mutex_t> lock(mtx_);
+	opts_ = opts;
+}
+
+WsDnsOpts WsResolverCache::getOpts(void)
+{
+	std::lock_guard<lp_mutex_t> lock(mtx_);
+	return opts_;
+}
+
+WsDnsStats WsResolverCache::getStats(void) const
+{
+	return {
+		nr_hits_.load(std::memory_order_relaxed),
+		nr_misses_.load(std::memory_order_relaxed),
+		nr_refreshes_.load(std::memory_order_relaxed),
+		nr_errors_.load(std::memory_order_relaxed)
+	};
+}
+
+void WsResolverCache::__startResolve(const std::string &key,
+				     const std::string &host, uint16_t port,
+				     Entry &e)
+{
+	e.resolving = true;
+	resolver_.async_resolve(host, std::to_string(port),
+		[this, key](const beast::error_code &ec,
+			    tcp::resolver::results_type results) {
+			onResolve(key, ec, results);
+		});
+}
+
+void WsResolverCache::onResolve(const std::string &key,
+				const beast::error_code &ec,
+				const tcp::resolver::results_type &results)
+{
+	std::vector<OnResolve_t> waiters;
+	std::vector<tcp::endpoint> eps;
+	beast::error_code ret = ec;
+
+	{
+		std::lock_guard<lp_mutex_t> lock(mtx_);
+		Entry &e = entries_[key];
+
+		e.resolving = false;
+		waiters.swap(e.waiters);
+		if (ec) {
+			nr_errors_.fetch_add(1, std::memory_order_relaxed);
+
+			// Serve the last known addresses rather than nothing.
+			if (!e.eps.empty())
+				ret = {};
+		} else {
+			e.eps.clear();
+			for (const auto &r : results)
+				e.eps.push_back(r.endpoint());
+			e.expires = clock::now() + std::chrono::milliseconds(opts_.ttl_ms);
+		}
+
+		eps = e.eps;
+	}
+
+	for (auto &cb : waiters)
+		cb(ret, eps);
+}
+
+void WsResolverCache::resolve(const std::string &host, uint16_t port,
+			      OnResolve_t cb)
+{
+	std::string key = host + ':' + std::to_string(port);
+	std::vector<tcp::endpoint> eps;
+
+	{
+		std::lock_guard<lp_mutex_t> lock(mtx_);
+		Entry &e = entries_[key];
+		auto now = clock::now();
+
+		if (e.eps.empty() || now >= e.expires) {
+			nr_misses_.fetch_add(1, std::memory_order_relaxed);
+			e.waiters.push_back(std::move(cb));
+			if (!e.resolving)
+				__startResolve(key, host, port, e);
+			return;
+		}
+
+		nr_hits_.fetch_add(1, std::memory_order_relaxed);
+		if (!e.resolving &&
+		    now + std::chrono::milliseconds(opts_.refresh_ahead_ms) >= e.expires) {
+			nr_refreshes_.fetch_add(1, std::memory_order_relaxed);
+			__startResolve(key, host, port, e);
+		}
+
+		eps = e.eps;
+	}
+
+	cb({}, eps);
+}
+
+void WsResolverCache::preResolve(const std::string &host, uint16_t port)
+{
+	std::string key = host + ':' + std::to_string(port);
+	std::lock_guard<lp_mutex_t> lock(mtx_);
+	Entry &e = entries_[key];
+
+	if (!e.resolving)
+		__startResolve(key, host, port, e);
+}
+
+/*
+ * Happy eyeballs (RFC 8305) connect: attempts to the resolved addresses
+ * are started connect_attempt_delay_ms apart, alternating between
+ * address families, and the first one to complete wins. A failed
+ * attempt starts the next one right away.
+ */
+class ConnectRace: public std::enable_shared_from_this<ConnectRace> {
+public:
+	typedef std::function<void(beast::error_code ec, tcp::socket sock,
+				   tcp::endpoint ep)> OnDone_t;
+
+private:
+	net::any_io_executor		ex_;
+	std::vector<tcp::endpoint>	eps_;
+	std::vector<std::unique_ptr<tcp::socket>> socks_;
+	net::steady_timer		delay_timer_;
+	net::steady_timer		deadline_;
+	std::chrono::milliseconds	delay_;
+	size_t				next_ = 0;
+	size_t				nr_pending_ = 0;
+	bool				done_ = false;
+	beast::error_code		last_ec_;
+	OnDone_t			on_done_;
+
+	inline void launchNext(void);
+	inline void onConnect(size_t i, const beast::error_code &ec);
+	inline void finish(const beast::error_code &ec, size_t i);
+
+public:
+	ConnectRace(net::any_io_executor ex, const std::vector<tcp::endpoint> &eps,
+		    const WsDnsOpts &opts, OnDone_t on_done);
+
+	void start(std::chrono::milliseconds timeout);
+};
+
+// Interleave the address families, keeping the resolver's order otherwise.
+static std::vector<tcp::endpoint> interleaveFamilies(const std::vector<tcp::endpoint> &eps)
+{
+	std::vector<tcp::endpoint> v4, v6, ret;
+	bool v6_first = !eps.empty() && eps.front().address().is_v6();
+	size_t i;
+
+	for (const auto &ep : eps)
+		(ep.address().is_v6() ? v6 : v4).push_back(ep);
+
+	std::vector<tcp::endpoint> &a = v6_first ? v6 : v4;
+	std::vector<tcp::endpoint> &b = v6_first ? v4 : v6;
+	for (i = 0; i < a.size() || i < b.size(); i++) {
+		if (i < a.size())
+			ret.push_back(a[i]);
+		if (i < b.size())
+			ret.push_back(b[i]);
+	}
+
+	return ret;
+}
+
+ConnectRace::ConnectRace(net::any_io_executor ex,
+			 const std::vector<tcp::endpoint> &eps,
+			 const WsDnsOpts &opts, OnDone_t on_done):
+	ex_(ex),
+	eps_(interleaveFamilies(eps)),
+	delay_timer_(ex),
+	deadline_(ex),
+	delay_(opts.connect_attempt_delay_ms),
+	on_done_(std::move(on_done))
+{
+}
+
+void ConnectRace::start(std::chrono::milliseconds timeout)
+{
+	auto self = shared_from_this();
+
+	if (eps_.empty()) {
+		finish(net::error::host_not_found, 0);
+		return;
+	}
+
+	deadline_.expires_after(timeout);
+	deadline_.async_wait([self](const beast::error_code &ec) {
+		if (!ec && !self->done_)
+			self->finish(net::error::timed_out, 0);
+	});
+
+	launchNext();
+}
+
+inline void ConnectRace::launchNext(void)
+{
+	auto self = shared_from_this();
+	size_t i = next_++;
+
+	socks_.push_back(std::make_unique<tcp::socket>(ex_));
+	nr_pending_++;
+	socks_[i]->async_connect(eps_[i], [self, i](const beast::error_code &ec) {
+		self->onConnect(i, ec);
+	});
+
+	if (next_ >= eps_.size() || !delay_.count())
+		return;
+
+	delay_timer_.expires_after(delay_);
+	delay_timer_.async_wait([self](const beast::error_code &ec) {
+		if (!ec && !self->done_ && self->next_ < self->eps_.size())
+			self->launchNext();
+	});
+}
+
+inline void ConnectRace::onConnect(size_t i, const beast::error_code &ec)
+{
+	nr_pending_--;
+	if (done_)
+		return;
+
+	if (!ec) {
+		finish(ec, i);
+		return;
+	}
+
+	last_ec_ = ec;
+	if (next_ < eps_.size()) {
+		delay_timer_.cancel();
+		launchNext();
+	} else if (!nr_pending_) {
+		finish(last_ec_, 0);
+	}
+}
+
+inline void ConnectRace::finish(const beast::error_code &ec, size_t i)
+{
+	beast::error_code ignored;
+	tcp::socket sock(ex_);
+	tcp::endpoint ep;
+	size_t j;
+
+	done_ = true;
+	delay_timer_.cancel();
+	deadline_.cancel();
+
+	if (!ec) {
+		sock = std::move(*socks_[i]);
+		ep = eps_[i];
+	}
+
+	for (j = 0; j < socks_.size(); j++) {
+		if (socks_[j]->is_open())
+			socks_[j]->close(ignored);
+	}
+
+	on_done_(ec, std::move(sock), ep);
+}
+
 WebsocketImplSession::WebsocketImplSession(net::io_context &ioc,
-					   ssl::context &ctx):
-	ws_(net::make_strand(ioc), ctx),
-	resolver_(net::make_strand(ioc)),
-	nr_read_after_(0)
+					   WebsocketTlsCtx &tls_ctx,
+					   WsResolverCache &resolver):
+	ex_(makeSessionExecutor(ioc)),
+	ws_(ex_, tls_ctx.getSSLCtx()),
+	ioc_(&ioc),
+	resolver_(&resolver),
+	tls_ctx_(&tls_ctx),
+	nr_read_after_(0),
+	hb_timer_(ex_)
 {
 }
 
 inline void WebsocketImplSession::invokeOnConnErr(beast::error_code &ec)
 {
+	if (failed_)
+		return;
+
+	failed_ = true;
 	if (onConnErr_)
 		onConnErr_(this, ec.value(), ec.message().c_str(), udata_);
 }
 
+#ifdef __linux__
+static inline void setIntSockOpt(int fd, int level, int name, int val)
+{
+	if (val < 0)
+		return;
+
+	// Best effort, the effective value is read back afterwards.
+	setsockopt(fd, level, name, &val, sizeof(val));
+}
+
+static inline int getIntSockOpt(int fd, int level, int name)
+{
+	socklen_t len = sizeof(int);
+	int val;
+
+	if (getsockopt(fd, level, name, &val, &len))
+		return -1;
+
+	return val;
+}
+#endif
+
+inline void WebsocketImplSession::applySockOpts(void)
+{
+	const WsSockOpts &o = sock_opts_;
+	WsSockOpts eff;
+
+#ifdef __linux__
+	int fd = beast::get_lowest_layer(ws_).socket().native_handle();
+
+	setIntSockOpt(fd, IPPROTO_TCP, TCP_NODELAY, o.tcp_nodelay);
+	setIntSockOpt(fd, IPPROTO_TCP, TCP_QUICKACK, o.tcp_quickack);
+	setIntSockOpt(fd, SOL_SOCKET, SO_RCVBUF, o.rcvbuf);
+	setIntSockOpt(fd, SOL_SOCKET, SO_SNDBUF, o.sndbuf);
+	setIntSockOpt(fd, SOL_SOCKET, SO_INCOMING_CPU, o.incoming_cpu);
+	setIntSockOpt(fd, SOL_SOCKET, SO_BUSY_POLL, o.busy_poll_us);
+
+	eff.tcp_nodelay = getIntSockOpt(fd, IPPROTO_TCP, TCP_NODELAY);
+	eff.tcp_quickack = getIntSockOpt(fd, IPPROTO_TCP, TCP_QUICKACK);
+	eff.rcvbuf = getIntSockOpt(fd, SOL_SOCKET, SO_RCVBUF);
+	eff.sndbuf = getIntSockOpt(fd, SOL_SOCKET, SO_SNDBUF);
+	eff.incoming_cpu = getIntSockOpt(fd, SOL_SOCKET, SO_INCOMING_CPU);
+	eff.busy_poll_us = getIntSockOpt(fd, SOL_SOCKET, SO_BUSY_POLL);
+#else
+	if (o.tcp_nodelay >= 0)
+		beast::get_lowest_layer(ws_).socket().set_option(tcp::no_delay(o.tcp_nodelay > 0));
+#endif
+
+	if (o.read_message_max >= 0)
+		ws_.read_message_max((std::size_t)o.read_message_max);
+	if (o.auto_fragment >= 0)
+		ws_.auto_fragment(o.auto_fragment > 0);
+	if (o.write_buffer_bytes >= 0)
+		ws_.write_buffer_bytes((std::size_t)o.write_buffer_bytes);
+
+	eff.read_message_max = (int64_t)ws_.read_message_max();
+	eff.auto_fragment = ws_.auto_fragment();
+	eff.write_buffer_bytes = (int64_t)ws_.write_buffer_bytes();
+
+	std::lock_guard<lp_mutex_t> lock(eff_opts_mtx_);
+	eff_sock_opts_ = eff;
+}
+
 void WebsocketImplSession::run(void)
 {
-	resolver_.async_resolve(host_, std::to_string(port_),
-				beast::bind_front_handler(
-					&WebsocketImplSession::onResolve,
-					shared_from_this()));
+	auto self = shared_from_this();
+
+	resolver_->resolve(host_, port_,
+		[self](const beast::error_code &ec, const std::vector<tcp::endpoint> &eps) {
+			net::dispatch(self->ex_, [self, ec, eps]() {
+				self->onResolve(ec, eps);
+			});
+		});
 }
 
 void WebsocketImplSession::onResolve(beast::error_code ec,
-				     tcp::resolver::results_type results)
+				     const std::vector<tcp::endpoint> &eps)
 {
+	WsDnsOpts opts = resolver_->getOpts();
+	auto self = shared_from_this();
+
+	if (closed_)
+		return;
+
 	if (ec) {
 		invokeOnConnErr(ec);
 		return;
 	}
 
-	beast::get_lowest_layer(ws_).expires_after(std::chrono::seconds(60));
-	beast::get_lowest_layer(ws_).async_connect(results,
-			beast::bind_front_handler(&WebsocketImplSession::onConnect,
-							shared_from_this()));
+	auto race = std::make_shared<ConnectRace>(ex_, eps, opts,
+		[self](beast::error_code ec, tcp::socket sock, tcp::endpoint ep) {
+			if (self->closed_)
+				return;
+			if (!ec)
+				beast::get_lowest_layer(self->ws_).socket() = std::move(sock);
+			self->onConnect(ec, ep);
+		});
+	race->start(std::chrono::milliseconds(opts.connect_timeout_ms));
 }
 
-void WebsocketImplSession::onConnect(beast::error_code ec,
-				     tcp::resolver::results_type::endpoint_type ep)
+void WebsocketImplSession::onConnect(beast::error_code ec, tcp::endpoint ep)
 {
+	SSL_SESSION *sess;
 	const char *host;
+	SSL *ssl;
 
 	if (ec) {
 		invokeOnConnErr(ec);
 		return;
 	}
 
+	applySockOpts();
+
 	beast::get_lowest_layer(ws_).expires_after(std::chrono::seconds(60));
 	host = host_.c_str();
-	if (!SSL_set_tlsext_host_name(ws_.next_layer().native_handle(), host))
+	ssl = ws_.next_layer().native_handle();
+	if (!SSL_set_tlsext_host_name(ssl, host))
+		return;
+
+	// The certificate must name the host, or carry the address when
+	// the host is an IP literal.
+	if (!X509_VERIFY_PARAM_set1_ip_asc(SSL_get0_param(ssl), host) &&
+	    !SSL_set1_host(ssl, host)) {
+		ec.assign((int)ERR_get_error(), net::error::get_ssl_category());
+		invokeOnConnErr(ec);
 		return;
+	}
+
+	SSL_set_ex_data(ssl, WebsocketTlsCtx::getSessionExIdx(), this);
+	sess = tls_ctx_->getSession(getTlsSessionKey());
+	if (sess) {
+		SSL_set_session(ssl, sess);
+		SSL_SESSION_free(sess);
+	}
 
-	host_ += ':' + std::to_string(ep.port());
+	hs_host_ = host_ + ':' + std::to_string(ep.port());
 	ws_.next_layer().async_handshake(ssl::stream_base::client,
-		beast::bind_front_handler(
-				&WebsocketImplSession::onSslHandshake,
-				shared_from_this()));
+		bindHandler(&WebsocketImplSession::onSslHandshake));
 }
 
 void WebsocketImplSession::onSslHandshake(beast::error_code ec)
@@ -76,8 +550,16 @@ void WebsocketImplSession::onSslHandshake(beast::error_code ec)
 
 	beast::get_lowest_layer(ws_).expires_never();
 
-	ws_.set_option(websocket::stream_base::timeout::suggested(
-			beast::role_type::client));
+	{
+		SSL *ssl = ws_.next_layer().native_handle();
+		std::lock_guard<lp_mutex_t> lock(eff_opts_mtx_);
+
+		tls_info_.resumed = SSL_session_reused(ssl);
+		tls_info_.version = SSL_get_version(ssl);
+		tls_info_.cipher = SSL_get_cipher_name(ssl);
+	}
+
+	applyStreamTimeout();
 
 	ws_.set_option(websocket::stream_base::decorator(
 		[ua = user_agent_](websocket::request_type& req)
@@ -85,8 +567,21 @@ void WebsocketImplSession::onSslHandshake(beast::error_code ec)
 			req.set(http::field::user_agent, ua);
 		}));
 
-	ws_.async_handshake(host_, uri_, beast::bind_front_handler(
-		&WebsocketImplSession::onHandshake, shared_from_this()));
+	ws_.async_handshake(hs_host_, uri_, bindHandler(&WebsocketImplSession::onHandshake));
+}
+
+inline void WebsocketImplSession::applyStreamTimeout(void)
+{
+	websocket::stream_base::timeout t =
+		websocket::stream_base::timeout::suggested(beast::role_type::client);
+
+	if (keepalive_ms_) {
+		// Beast pings at half the idle timeout.
+		t.idle_timeout = std::chrono::milliseconds(keepalive_ms_ * 2);
+		t.keep_alive_pings = true;
+	}
+
+	ws_.set_option(t);
 }
 
 void WebsocketImplSession::onHandshake(beast::error_code ec)
@@ -96,69 +591,141 @@ void WebsocketImplSession::onHandshake(beast::error_code ec)
 		return;
 	}
 
+	connected_ = true;
+	last_rx_ns_ = nowNs();
+	if (hb_.interval_ms)
+		armHeartbeat();
+
 	if (onConnect_)
 		onConnect_(this, udata_);
 
-	std::lock_guard<std::mutex> lock(wq_mtx_);
-	if (!write_queue_.empty()) {
-		struct write_buf &wb = write_queue_.front();
-		ws_.async_write(net::buffer(wb.data(), wb.len()),
-				beast::bind_front_handler(
-					&WebsocketImplSession::onWrite,
-					shared_from_this()));
+	kickWrite();
+	popNrRead();
+}
+
+inline void WebsocketImplSession::armHeartbeat(void)
+{
+	uint64_t tick = std::min(hb_.interval_ms, hb_.timeout_ms) / 4;
+
+	hb_timer_.expires_after(std::chrono::milliseconds(tick ? tick : 1));
+	hb_timer_.async_wait(bindHandler(&WebsocketImplSession::onHeartbeat));
+}
+
+inline bool WebsocketImplSession::isPong(const char *data, size_t len)
+{
+	return hb_.interval_ms && len == hb_.pong.size() &&
+	       !memcmp(data, hb_.pong.data(), len);
+}
+
+void WebsocketImplSession::onHeartbeat(beast::error_code ec)
+{
+	uint64_t now = nowNs();
+	uint64_t interval_ns = hb_.interval_ms * 1000000ull;
+	uint64_t timeout_ns = hb_.timeout_ms * 1000000ull;
+
+	if (ec || closed_ || failed_ || !hb_.interval_ms)
+		return;
+
+	if (ping_sent_ns_ && now - ping_sent_ns_ >= timeout_ns) {
+		if (last_rx_ns_ < ping_sent_ns_) {
+			ec = net::error::timed_out;
+			invokeOnConnErr(ec);
+			beast::get_lowest_layer(ws_).close();
+			return;
+		}
+
+		// Data kept flowing but the pong got lost.
+		ping_sent_ns_ = 0;
+	}
+
+	if (!ping_sent_ns_ && now - last_rx_ns_ >= interval_ns) {
+		ping_sent_ns_ = now;
+		write(hb_.ping.data(), hb_.ping.size());
 	}
+
+	armHeartbeat();
+}
+
+/*
+ * Reads and writes are independent: at most one of each is in flight,
+ * writes are started from the queue whenever none is.
+ */
+void WebsocketImplSession::kickWrite(void)
+{
+	if (!connected_ || write_in_flight_)
+		return;
+
+	std::lock_guard<lp_mutex_t> lock(wq_mtx_);
+	if (write_queue_.empty())
+		return;
+
+	struct write_buf &wb = write_queue_.front();
+	wb.sending_ = true;
+	write_in_flight_ = true;
+	ws_.async_write(net::buffer(wb.data(), wb.len()),
+			bindHandler(&WebsocketImplSession::onWrite));
 }
 
 void WebsocketImplSession::onWrite(beast::error_code ec,
 				   std::size_t bytes_transferred)
 {
+	write_in_flight_ = false;
 	if (ec) {
 		invokeOnConnErr(ec);
 		return;
 	}
 
+	{
+		std::lock_guard<lp_mutex_t> lock(wq_mtx_);
+		wq_stats_.depth--;
+		wq_stats_.bytes -= write_queue_.front().len();
+		write_queue_.pop_front();
+	}
+
+	if constexpr (LockPolicy::threaded)
+		wq_cv_.notify_all();
+
 	if (onWrite_)
 		onWrite_(this, bytes_transferred, udata_);
 
-	std::lock_guard<std::mutex> lock(wq_mtx_);
-	write_queue_.pop();
-	if (!write_queue_.empty()) {
-		struct write_buf &wb = write_queue_.front();
-		ws_.async_write(net::buffer(wb.data(), wb.len()),
-				beast::bind_front_handler(
-					&WebsocketImplSession::onWrite,
-					shared_from_this()));
-	} else {
-		popNrRead();
-	}
+	kickWrite();
+	popNrRead();
 }
 
 void WebsocketImplSession::onRead(beast::error_code ec,
 				  std::size_t bytes_transferred)
 {
+	read_in_flight_ = false;
 	if (ec) {
 		invokeOnConnErr(ec);
 		return;
 	}
 
-	if (onRead_) {
+#ifdef __linux__
+	if (sock_opts_.tcp_quickack > 0) {
+		int fd = beast::get_lowest_layer(ws_).socket().native_handle();
+		setIntSockOpt(fd, IPPROTO_TCP, TCP_QUICKACK, 1);
+	}
+#endif
+
+	last_rx_ns_ = nowNs();
+	if (isPong(reinterpret_cast<const char *>(buffer_.data().data()), buffer_.size())) {
+		if (ping_sent_ns_) {
+			if (hb_rtt_)
+				hb_rtt_->record(last_rx_ns_ - ping_sent_ns_);
+			ping_sent_ns_ = 0;
+		}
+		buffer_.consume(buffer_.size());
+	} else if (onRead_) {
 		const char *buf = reinterpret_cast<const char *>(buffer_.data().data());
 		size_t len = buffer_.size();
-		buffer_.consume(onRead_(this, buf, len, udata_));
+		buffer_.consume(onRead_(static_cast<WebsocketSession *>(udata_), buf, len));
 	} else {
 		buffer_.consume(bytes_transferred);
 	}
 
-	std::lock_guard<std::mutex> lock(wq_mtx_);
-	if (!write_queue_.empty()) {
-		struct write_buf &wb = write_queue_.front();
-		ws_.async_write(net::buffer(wb.data(), wb.len()),
-				beast::bind_front_handler(
-					&WebsocketImplSession::onWrite,
-					shared_from_this()));
-	} else {
-		popNrRead();
-	}
+	popNrRead();
+	kickWrite();
 }
 
 void WebsocketImplSession::onClose(beast::error_code ec)
@@ -170,6 +737,16 @@ void WebsocketImplSession::onClose(beast::error_code ec)
 
 bool WebsocketImplSession::popNrRead(void)
 {
+	if (read_in_flight_ || !connected_)
+		return false;
+
+	// Liveness is judged by what arrives, so heartbeats need a read
+	// pending at all times.
+	if (auto_read_ || hb_.interval_ms) {
+		read();
+		return true;
+	}
+
 	if (nr_read_after_.fetch_sub(1) > 0) {
 		read();
 		return true;
@@ -179,40 +756,260 @@ bool WebsocketImplSession::popNrRead(void)
 	}
 }
 
-void WebsocketImplSession::write(const void *data, size_t len)
+inline bool WebsocketImplSession::__wqFull(size_t len) const
+{
+	if (wq_opts_.max_msgs && wq_stats_.depth >= wq_opts_.max_msgs)
+		return true;
+
+	// A single message larger than the limit still goes out alone.
+	if (wq_opts_.max_bytes && wq_stats_.depth &&
+	    wq_stats_.bytes + len > wq_opts_.max_bytes)
+		return true;
+
+	return false;
+}
+
+/*
+ * Merge @wb into an unsent message with the same class and key. Returns
+ * true if @wb has been consumed.
+ */
+inline bool WebsocketImplSession::__wqCoalesce(struct write_buf &wb)
+{
+	if (wb.key_.empty())
+		return false;
+
+	for (auto it = write_queue_.rbegin(); it != write_queue_.rend(); it++) {
+		if (it->sending_ || it->cls_ != wb.cls_ || it->key_ != wb.key_)
+			continue;
+
+		wq_stats_.bytes -= it->len();
+		if (wb.op_ && it->op_ == -wb.op_) {
+			write_queue_.erase(std::next(it).base());
+			wq_stats_.depth--;
+			wq_stats_.nr_coalesced += 2;
+		} else {
+			wq_stats_.bytes += wb.len();
+			*it = std::move(wb);
+			wq_stats_.nr_coalesced++;
+		}
+		return true;
+	}
+
+	return false;
+}
+
+int WebsocketImplSession::write(const void *data, size_t len, const WsMsgMeta *meta)
 {
 	struct write_buf wb;
+	WsQueuePolicy policy;
+	bool was_empty;
 
 	if (!wb.set(data, len))
 		throw std::bad_alloc();
 
-	std::lock_guard<std::mutex> lock(wq_mtx_);
-	write_queue_.push(std::move(wb));
+	if (meta) {
+		wb.cls_ = meta->cls;
+		wb.op_ = meta->op;
+		wb.key_ = meta->key;
+	}
+
+	{
+		std::unique_lock<lp_mutex_t> lock(wq_mtx_);
+
+		policy = wq_opts_.policy[(size_t)wb.cls_];
+		if (policy == WsQueuePolicy::Coalesce && __wqCoalesce(wb)) {
+			if constexpr (LockPolicy::threaded)
+				wq_cv_.notify_all();
+			return 0;
+		}
+
+		if (__wqFull(len)) {
+			bool can_block = LockPolicy::threaded &&
+					 policy == WsQueuePolicy::Block &&
+					 !ioc_->get_executor().running_in_this_thread();
+
+			if (can_block) {
+				wq_stats_.nr_blocked++;
+				wq_cv_.wait_for(lock,
+					std::chrono::milliseconds(wq_opts_.block_timeout_ms),
+					[this, len]() { return closed_ || !__wqFull(len); });
+			}
+
+			if (closed_ || __wqFull(len)) {
+				wq_stats_.nr_rejected++;
+				return -ENOBUFS;
+			}
+		}
+
+		was_empty = write_queue_.empty();
+		write_queue_.push_back(std::move(wb));
+		wq_stats_.depth++;
+		wq_stats_.bytes += len;
+		if (wq_stats_.depth > wq_stats_.max_depth)
+			wq_stats_.max_depth = wq_stats_.depth;
+	}
+
+	/*
+	 * A non-empty queue is drained by the write in flight, or by the
+	 * handshake if not connected yet.
+	 */
+	if (was_empty) {
+		auto self = shared_from_this();
+		net::post(ex_, makeAllocHandler(arena_, [self]() {
+			self->kickWrite();
+		}));
+	}
+
+	return 0;
+}
+
+void WebsocketImplSession::setQueueOpts(const WsQueueOpts &opts)
+{
+	std::lock_guard<lp_mutex_t> lock(wq_mtx_);
+	wq_opts_ = opts;
+}
+
+WsQueueStats WebsocketImplSession::getQueueStats(void) const
+{
+	std::lock_guard<lp_mutex_t> lock(wq_mtx_);
+	return wq_stats_;
 }
 
 void WebsocketImplSession::read(void)
 {
+	read_in_flight_ = true;
 	ws_.async_read(buffer_,
-		beast::bind_front_handler(
-			&WebsocketImplSession::onRead,
-			shared_from_this()));
+		bindHandler(&WebsocketImplSession::onRead));
+}
+
+void WebsocketImplSession::copySettings(const WebsocketImplSession &o)
+{
+	user_agent_ = o.user_agent_;
+	uri_ = o.uri_;
+	host_ = o.host_;
+	port_ = o.port_;
+	sock_opts_ = o.sock_opts_;
+	hb_ = o.hb_;
+	hb_rtt_ = o.hb_rtt_;
+
+	std::lock_guard<lp_mutex_t> lock(o.wq_mtx_);
+	wq_opts_ = o.wq_opts_;
+}
+
+void WebsocketImplSession::promote(std::function<void(void)> then)
+{
+	auto self = shared_from_this();
+
+	net::post(ex_, [self, then]() {
+		self->auto_read_ = false;
+		self->keepalive_ms_ = 0;
+		if (self->connected_)
+			self->applyStreamTimeout();
+
+		then();
+		self->kickWrite();
+		self->popNrRead();
+	});
+}
+
+void WebsocketImplSession::close(std::function<void(void)> then)
+{
+	auto self = shared_from_this();
+
+	net::post(ex_, [self, then]() {
+		{
+			// Blocked writers give up.
+			std::lock_guard<lp_mutex_t> lock(self->wq_mtx_);
+			self->closed_ = true;
+		}
+
+		if constexpr (LockPolicy::threaded)
+			self->wq_cv_.notify_all();
+
+		self->udata_ = nullptr;
+		self->onConnect_ = nullptr;
+		self->onRead_ = nullptr;
+		self->onWrite_ = nullptr;
+		self->onClose_ = nullptr;
+		self->onConnErr_ = nullptr;
+
+		// Pending operations complete with operation_aborted.
+		self->hb_timer_.cancel();
+		beast::get_lowest_layer(self->ws_).close();
+
+		if (then)
+			then();
+	});
 }
 
 WebsocketImplSession::~WebsocketImplSession(void) = default;
 
 WebsocketImpl::WebsocketImpl(void):
+	WebsocketImpl(std::make_shared<WebsocketTlsCtx>())
+{
+}
+
+WebsocketImpl::WebsocketImpl(std::shared_ptr<WebsocketTlsCtx> tls_ctx):
 	io_ctx_(),
-	ssl_ctx_(ssl::context::tlsv12_client)
+	tls_ctx_(std::move(tls_ctx)),
+	resolver_(io_ctx_)
 {
-	load_root_certificates(ssl_ctx_);
 }
 
 WebsocketImpl::~WebsocketImpl(void) = default;
 
+/*
+ * Run the io_context without parking in epoll: poll() is called in a
+ * tight loop so inbound frames are picked up without a wakeup. With
+ * @spin_idle_ns set, an idle period that long falls back to a blocking
+ * run_one() so an idle feed does not burn a core forever.
+ */
+void WebsocketImpl::runBusyPoll(uint64_t spin_idle_ns)
+{
+	auto idle_start = std::chrono::steady_clock::now();
+
+	while (!io_ctx_.stopped()) {
+		if (io_ctx_.poll()) {
+			if (spin_idle_ns)
+				idle_start = std::chrono::steady_clock::now();
+			continue;
+		}
+
+		if (!spin_idle_ns)
+			continue;
+
+		auto now = std::chrono::steady_clock::now();
+		if ((uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+				now - idle_start).count() < spin_idle_ns)
+			continue;
+
+		io_ctx_.run_one();
+		idle_start = std::chrono::steady_clock::now();
+	}
+}
+
+// static
+void WebsocketImpl::pinThisThread(int cpu)
+{
+#ifdef __linux__
+	cpu_set_t set;
+	int ret;
+
+	CPU_ZERO(&set);
+	CPU_SET(cpu, &set);
+	ret = pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+	if (ret)
+		throw std::system_error(ret, std::generic_category(),
+					"pthread_setaffinity_np");
+#else
+	(void)cpu;
+#endif
+}
+
 std::shared_ptr<WebsocketImplSession>
 WebsocketImpl::createSession(void)
 {
-	return std::make_shared<WebsocketImplSession>(io_ctx_, ssl_ctx_);
+	return std::make_shared<WebsocketImplSession>(io_ctx_, *tls_ctx_, resolver_);
 }
 
 } /* namespace exc */
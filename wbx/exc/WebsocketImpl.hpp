@@ -15,13 +15,23 @@
 #include <boost/asio/ip/tcp.hpp>
 #include <boost/asio/ssl.hpp>
 
+#include <chrono>
 #include <cstdlib>
 #include <functional>
 #include <iostream>
 #include <memory>
 #include <string>
 #include <atomic>
-#include <queue>
+#include <deque>
+#include <condition_variable>
+#include <vector>
+#include <unordered_map>
+
+#include <wbx/exc/LockPolicy.hpp>
+#include <wbx/exc/FuncRef.hpp>
+#include <wbx/exc/HandlerAlloc.hpp>
+#include <wbx/exc/WebsocketOpts.hpp>
+#include <wbx/exc/Histogram.hpp>
 
 namespace wbx {
 namespace exc {
@@ -34,16 +44,115 @@ namespace ssl = boost::asio::ssl;       // from <boost/asio/ssl.hpp>
 using tcp = boost::asio::ip::tcp;       // from <boost/asio/ip/tcp.hpp>
 
 class WebsocketImplSession;
+class WebsocketSession;
+
+/*
+ * TLS client context shared by any number of Websocket instances.
+ *
+ * TLS 1.3 is preferred with an AEAD-only cipher list, and a client-side
+ * session cache keyed by host:port lets reconnects resume with a session
+ * ticket instead of doing a full handshake.
+ */
+class WebsocketTlsCtx {
+private:
+	ssl::context	ctx_;
+	uint64_t	trust_store_load_ns_;
+
+	lp_mutex_t	cache_mtx_;
+	std::unordered_map<std::string, SSL_SESSION *> cache_;
+
+	static int newSessionCb(SSL *ssl, SSL_SESSION *sess);
+
+public:
+	explicit WebsocketTlsCtx(const WsTlsOpts &opts = WsTlsOpts());
+	~WebsocketTlsCtx(void);
+
+	// Time spent attaching the trust store; ~0 once it has been built.
+	inline uint64_t getTrustStoreLoadNs(void) const { return trust_store_load_ns_; }
+
+	static int getSessionExIdx(void);
+
+	inline ssl::context &getSSLCtx(void) { return ctx_; }
+
+	// Returns an extra reference the caller must free, or nullptr.
+	SSL_SESSION *getSession(const std::string &key);
+	void putSession(const std::string &key, SSL_SESSION *sess);
+};
+
+/*
+ * Resolved address lists shared by all sessions of a WebsocketImpl,
+ * keyed by host:port. Lookups for an entry being resolved wait for the
+ * same query instead of starting their own, and entries close to expiry
+ * are refreshed in the background so connects do not wait on DNS.
+ */
+class WsResolverCache {
+public:
+	typedef std::function<void(const beast::error_code &ec,
+				   const std::vector<tcp::endpoint> &eps)> OnResolve_t;
+
+private:
+	typedef std::chrono::steady_clock clock;
+
+	struct Entry {
+		std::vector<tcp::endpoint>	eps;
+		clock::time_point		expires;
+		bool				resolving = false;
+		std::vector<OnResolve_t>	waiters;
+	};
+
+	tcp::resolver		resolver_;
+	lp_mutex_t		mtx_;
+	WsDnsOpts		opts_;
+	std::unordered_map<std::string, Entry> entries_;
+
+	std::atomic<uint64_t>	nr_hits_;
+	std::atomic<uint64_t>	nr_misses_;
+	std::atomic<uint64_t>	nr_refreshes_;
+	std::atomic<uint64_t>	nr_errors_;
+
+	void __startResolve(const std::string &key, const std::string &host,
+			    uint16_t port, Entry &e);
+	void onResolve(const std::string &key, const beast::error_code &ec,
+		       const tcp::resolver::results_type &results);
+
+public:
+	explicit WsResolverCache(net::io_context &ioc);
+
+	void setOpts(const WsDnsOpts &opts);
+	WsDnsOpts getOpts(void);
+
+	// @cb may be called before this returns.
+	void resolve(const std::string &host, uint16_t port, OnResolve_t cb);
+	void preResolve(const std::string &host, uint16_t port);
+	WsDnsStats getStats(void) const;
+};
+
+/*
+ * Sessions are bound to a strand only when the io_context may be run
+ * from more than one thread.
+ */
+static inline net::any_io_executor makeSessionExecutor(net::io_context &ioc)
+{
+	if constexpr (LockPolicy::threaded)
+		return net::make_strand(ioc);
+	else
+		return ioc.get_executor();
+}
 
 typedef std::function<void(WebsocketImplSession *ws_sess, void *udata)> WsImplOnConnect_t;
-typedef std::function<size_t(WebsocketImplSession *ws_sess, const char *data, size_t len, void *udata)> WsImplOnRead_t;
+typedef FuncRef<size_t(WebsocketSession *ws_sess, const char *data, size_t len)> WsImplOnRead_t;
 typedef std::function<void(WebsocketImplSession *ws_sess, size_t len, void *udata)> WsImplOnWrite_t;
 typedef std::function<void(WebsocketImplSession *ws_sess, void *udata)> WsImplOnClose_t;
 typedef std::function<void(WebsocketImplSession *ws_sess, int code, const char *msg, void *udata)> WsImplOnConnErr_t;
 
 struct write_buf {
-	void	*data_;
-	size_t	len_;
+	void		*data_;
+	size_t		len_;
+	WsMsgClass	cls_ = WsMsgClass::Default;
+	int		op_ = 0;
+	// Handed to the socket, must stay at the front.
+	bool		sending_ = false;
+	std::string	key_;
 
 	inline write_buf(void) noexcept:
 		data_(nullptr),
@@ -59,7 +168,11 @@ struct write_buf {
 
 	inline write_buf(write_buf &&other) noexcept:
 		data_(other.data_),
-		len_(other.len_)
+		len_(other.len_),
+		cls_(other.cls_),
+		op_(other.op_),
+		sending_(other.sending_),
+		key_(std::move(other.key_))
 	{
 		other.data_ = nullptr;
 		other.len_ = 0;
@@ -72,6 +185,10 @@ struct write_buf {
 				free(data_);
 			data_ = other.data_;
 			len_ = other.len_;
+			cls_ = other.cls_;
+			op_ = other.op_;
+			sending_ = other.sending_;
+			key_ = std::move(other.key_);
 			other.data_ = nullptr;
 			other.len_ = 0;
 		}
@@ -96,36 +213,118 @@ struct write_buf {
 
 class WebsocketImplSession: public std::enable_shared_from_this<WebsocketImplSession> {
 private:
+	// A copy of the stream's executor. Connecting replaces the socket
+	// and the executor inside it, so other threads post through this one.
+	net::any_io_executor	ex_;
 	websocket::stream<beast::ssl_stream<beast::tcp_stream>> ws_;
-	tcp::resolver		resolver_;
+	net::io_context		*ioc_;
+	WsResolverCache		*resolver_;
 	beast::flat_buffer	buffer_;
 	std::string		user_agent_;
 	std::string		uri_;
 	std::string		host_;
+	std::string		hs_host_;
 	uint16_t		port_;
+	WsSockOpts		sock_opts_;
+
+	WebsocketTlsCtx		*tls_ctx_;
+	WsTlsInfo		tls_info_;
+
+	mutable lp_mutex_t	eff_opts_mtx_;
+	WsSockOpts		eff_sock_opts_;
 
 	void			*udata_ = nullptr;
 	WsImplOnConnect_t	onConnect_ = nullptr;
-	WsImplOnRead_t		onRead_ = nullptr;
+	WsImplOnRead_t		onRead_;
 	WsImplOnWrite_t		onWrite_ = nullptr;
 	WsImplOnClose_t		onClose_ = nullptr;
 	WsImplOnConnErr_t	onConnErr_ = nullptr;
 	std::atomic<int64_t>	nr_read_after_;
+	bool			closed_ = false;
+	// An impl session reports at most one error.
+	bool			failed_ = false;
+
+	// Executor-only state.
+	bool			connected_ = false;
+	bool			read_in_flight_ = false;
+	bool			write_in_flight_ = false;
+	// Keep a read pending regardless of readAfter(), used by idle
+	// standby connections so control frames are answered.
+	bool			auto_read_ = false;
+	// Non-zero: websocket ping after this long without traffic.
+	uint64_t		keepalive_ms_ = 0;
+
+	WsHeartbeatOpts		hb_;
+	LatencyHistogram	*hb_rtt_ = nullptr;
+	uint64_t		last_rx_ns_ = 0;
+	// Send time of the outstanding heartbeat ping, 0 if none.
+	uint64_t		ping_sent_ns_ = 0;
+
+	mutable lp_mutex_t		wq_mtx_;
+	std::condition_variable_any	wq_cv_;
+	std::deque<struct write_buf>	write_queue_;
+	WsQueueOpts			wq_opts_;
+	WsQueueStats			wq_stats_ = {};
 
-	std::mutex			wq_mtx_;
-	std::queue<struct write_buf>	write_queue_;
+	// Completion handler memory of this session's async operations.
+	HandlerArena			arena_;
+	net::steady_timer		hb_timer_;
 
 	bool popNrRead(void);
+	void kickWrite(void);
 	inline void invokeOnConnErr(beast::error_code &ec);
+	inline void applyStreamTimeout(void);
+	inline void armHeartbeat(void);
+	inline bool isPong(const char *data, size_t len);
+	void onHeartbeat(beast::error_code ec);
+	inline void applySockOpts(void);
+	inline bool __wqFull(size_t len) const;
+	inline bool __wqCoalesce(struct write_buf &wb);
+
+	template<typename F>
+	inline auto bindHandler(F f)
+	{
+		return makeAllocHandler(arena_, beast::bind_front_handler(f, shared_from_this()));
+	}
 
 public:
-	explicit WebsocketImplSession(net::io_context &ioc, ssl::context &ctx);
+	explicit WebsocketImplSession(net::io_context &ioc, WebsocketTlsCtx &tls_ctx,
+				      WsResolverCache &resolver);
 	~WebsocketImplSession(void);
 
 	inline void setUserAgent(const std::string &userAgent) { user_agent_ = userAgent; }
 	inline void setUri(const std::string &uri) { uri_ = uri; }
 	inline void setHost(const std::string &host) { host_ = host; }
 	inline void setPort(uint16_t port) { port_ = port; }
+	inline void setSockOpts(const WsSockOpts &opts) { sock_opts_ = opts; }
+	inline void setBusyPoll(unsigned usec) { sock_opts_.busy_poll_us = (int)usec; }
+	inline void setAutoRead(bool enable) { auto_read_ = enable; }
+	inline void setKeepAlive(uint64_t ms) { keepalive_ms_ = ms; }
+
+	// Before run(), or on the session's executor. @rtt may be null.
+	inline void setHeartbeat(const WsHeartbeatOpts &opts, LatencyHistogram *rtt)
+	{
+		hb_ = opts;
+		hb_rtt_ = rtt;
+	}
+
+	// Take host, port, uri, user agent, socket, heartbeat and queue options of @o.
+	void copySettings(const WebsocketImplSession &o);
+
+	inline WsSockOpts getEffectiveSockOpts(void) const
+	{
+		std::lock_guard<lp_mutex_t> lock(eff_opts_mtx_);
+		return eff_sock_opts_;
+	}
+
+	inline WsTlsInfo getTlsInfo(void) const
+	{
+		std::lock_guard<lp_mutex_t> lock(eff_opts_mtx_);
+		return tls_info_;
+	}
+
+	inline std::string getTlsSessionKey(void) const { return host_ + ':' + std::to_string(port_); }
+	inline WebsocketTlsCtx *getTlsCtx(void) { return tls_ctx_; }
 	inline void setUData(void *udata) { udata_ = udata; }
 	inline void setOnConnect(WsImplOnConnect_t onConnect) { onConnect_ = onConnect; }
 	inline void setOnRead(WsImplOnRead_t onRead) { onRead_ = onRead; }
@@ -134,33 +333,58 @@ public:
 	inline void setOnConnErr(WsImplOnConnErr_t onConnErr) { onConnErr_ = onConnErr; }
 
 	void run(void);
-	void onResolve(beast::error_code ec, tcp::resolver::results_type results);
-	void onConnect(beast::error_code ec, tcp::resolver::results_type::endpoint_type ep);
+	void onResolve(beast::error_code ec, const std::vector<tcp::endpoint> &eps);
+	void onConnect(beast::error_code ec, tcp::endpoint ep);
 	void onSslHandshake(beast::error_code ec);
 	void onHandshake(beast::error_code ec);
 	void onWrite(beast::error_code ec, std::size_t bytes_transferred);
 	void onRead(beast::error_code ec, std::size_t bytes_transferred);
 	void onClose(beast::error_code ec);
 
-	void write(const void *data, size_t len);
+	// 0 if queued, -ENOBUFS if the queue policy refused the message.
+	int write(const void *data, size_t len, const WsMsgMeta *meta = nullptr);
 	void read(void);
+
+	void setQueueOpts(const WsQueueOpts &opts);
+	WsQueueStats getQueueStats(void) const;
+
+	/*
+	 * Drop the connection and detach all callbacks, on the session's
+	 * executor. @then runs there once no callback can fire anymore.
+	 */
+	void close(std::function<void(void)> then = nullptr);
+
+	/*
+	 * Turn an idle standby connection into a regular one, on the
+	 * session's executor: auto read and keep-alive pings are switched
+	 * off and @then runs before pending writes are started.
+	 */
+	void promote(std::function<void(void)> then);
 	inline void readAfter(void) { nr_read_after_.fetch_add(1); }
+	inline HandlerAllocStats getHandlerAllocStats(void) const { return arena_.getStats(); }
 };
 
 class WebsocketImpl {
 private:
-	net::io_context		io_ctx_;
-	ssl::context		ssl_ctx_;
+	net::io_context				io_ctx_;
+	std::shared_ptr<WebsocketTlsCtx>	tls_ctx_;
+	WsResolverCache				resolver_;
 
 public:
 	WebsocketImpl(void);
+	explicit WebsocketImpl(std::shared_ptr<WebsocketTlsCtx> tls_ctx);
 	~WebsocketImpl(void);
 
 	std::shared_ptr<WebsocketImplSession> createSession(void);
 
 	inline net::io_context &getIOCtx(void) { return io_ctx_; }
-	inline ssl::context &getSSLCtx(void) { return ssl_ctx_; }
+	inline ssl::context &getSSLCtx(void) { return tls_ctx_->getSSLCtx(); }
+	inline std::shared_ptr<WebsocketTlsCtx> getTlsCtx(void) { return tls_ctx_; }
+	inline WsResolverCache &getResolver(void) { return resolver_; }
 	inline void run(void) { io_ctx_.run(); }
+	void runBusyPoll(uint64_t spin_idle_ns);
+
+	static void pinThisThread(int cpu);
 };
 
 } /* namespace exc */
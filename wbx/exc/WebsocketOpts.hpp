@@ -0,0 +1,177 @@
+// SPDX-License-Identifier: GPL-2.0-only
+
+#ifndef EXC__WEBSOCKET_OPTS__HPP
+#define EXC__WEBSOCKET_OPTS__HPP
+
+#include <string>
+#include <vector>
+#include <cstdint>
+
+/*
+ * Plain option structs shared by Websocket.hpp and WebsocketImpl.hpp.
+ * Must not pull in Boost.
+ */
+namespace wbx {
+namespace exc {
+
+struct WsRunOpts {
+	// CPU the io thread is pinned to, -1 leaves the affinity alone.
+	int		cpu = -1;
+
+	// Spin on io_context::poll() instead of parking in epoll.
+	bool		busy_poll = false;
+
+	// Busy poll only: after this long without a completed handler,
+	// block in run_one() until the next event. 0 spins forever.
+	uint64_t	spin_idle_ns = 0;
+};
+
+/*
+ * Per-session socket and websocket stream tuning, applied right after
+ * the TCP connect. A negative value leaves the kernel / Beast default.
+ * The same struct is used to report the effective values back.
+ */
+struct WsSockOpts {
+	int		tcp_nodelay = -1;
+	// TCP_QUICKACK is not sticky, it is re-armed after every read.
+	int		tcp_quickack = -1;
+	// Set after connect, so the advertised window scale is whatever
+	// the kernel picked for the SYN.
+	int		rcvbuf = -1;
+	int		sndbuf = -1;
+	int		incoming_cpu = -1;
+	int		busy_poll_us = -1;
+
+	int64_t		read_message_max = -1;
+	int		auto_fragment = -1;
+	int64_t		write_buffer_bytes = -1;
+};
+
+/*
+ * Resolver cache and connect behaviour of one Websocket instance.
+ */
+struct WsDnsOpts {
+	// getaddrinfo() does not expose record TTLs, so resolved address
+	// lists are kept for a fixed time.
+	uint32_t	ttl_ms = 60000;
+	// A lookup hitting an entry this close to expiry returns the cached
+	// addresses and re-resolves in the background.
+	uint32_t	refresh_ahead_ms = 15000;
+	// Happy eyeballs: the next address is tried this long after the
+	// previous attempt started, without waiting for it to fail.
+	// 0 tries the addresses one after another.
+	uint32_t	connect_attempt_delay_ms = 250;
+	uint32_t	connect_timeout_ms = 60000;
+};
+
+struct WsDnsStats {
+	uint64_t	nr_hits;
+	uint64_t	nr_misses;
+	uint64_t	nr_refreshes;
+	uint64_t	nr_errors;
+};
+
+/*
+ * Application-level heartbeat. When nothing was received for
+ * interval_ms, @ping is sent as a text message; replies equal to @pong
+ * are timed and not passed to onRead. A connection that receives
+ * nothing for timeout_ms after a ping is dead and fails with timed_out.
+ * A read is kept pending while the heartbeat is on.
+ */
+struct WsHeartbeatOpts {
+	std::string	ping = "ping";
+	std::string	pong = "pong";
+	// 0 disables the heartbeat.
+	uint64_t	interval_ms = 0;
+	uint64_t	timeout_ms = 1000;
+};
+
+/*
+ * Outbound messages are queued per session until the socket takes
+ * them. Each message has a class; what happens when the queue is full
+ * depends on the class's policy.
+ */
+enum class WsMsgClass : uint8_t {
+	Default,
+	// Subscribe / unsubscribe requests.
+	Subscription,
+	Order,
+	NR_CLASSES,
+};
+
+enum class WsQueuePolicy : uint8_t {
+	// Wait up to WsQueueOpts::block_timeout_ms for room, then reject.
+	// Rejects right away on the io thread.
+	Block,
+	// Fail the write with -ENOBUFS.
+	Reject,
+	/*
+	 * A message with the key of an unsent one supersedes it: opposite
+	 * ops (subscribe + unsubscribe) cancel each other, otherwise the
+	 * newer payload takes the queued message's place. Applies even
+	 * when the queue is not full; rejects if nothing could be merged.
+	 */
+	Coalesce,
+};
+
+struct WsMsgMeta {
+	WsMsgClass	cls = WsMsgClass::Default;
+	// Empty never coalesces.
+	std::string	key;
+	// +1 / -1 for a request and its inverse, 0 for neither.
+	int		op = 0;
+};
+
+struct WsQueueOpts {
+	// 0 means unbounded.
+	size_t		max_msgs = 0;
+	size_t		max_bytes = 0;
+	uint64_t	block_timeout_ms = 1000;
+	WsQueuePolicy	policy[(size_t)WsMsgClass::NR_CLASSES] = {
+		WsQueuePolicy::Block,
+		WsQueuePolicy::Coalesce,
+		WsQueuePolicy::Reject,
+	};
+};
+
+struct WsQueueStats {
+	size_t		depth;
+	size_t		bytes;
+	// High watermark of depth.
+	size_t		max_depth;
+	uint64_t	nr_rejected;
+	// Messages dropped or merged by coalescing.
+	uint64_t	nr_coalesced;
+	// Writes that had to wait for room.
+	uint64_t	nr_blocked;
+};
+
+enum class WsTrustStore {
+	// Certificates embedded in RootCerts.cpp.
+	Bundled,
+	// OpenSSL default paths (the distribution's CA store).
+	System,
+	// Only the embedded certificates named in WsTlsOpts::pinned_cas.
+	Pinned,
+};
+
+struct WsTlsOpts {
+	WsTrustStore			trust_store = WsTrustStore::Bundled;
+	// "# Name" headers of the RootCerts.cpp entries to trust.
+	std::vector<std::string>	pinned_cas;
+	// Check the server's chain against the trust store and its name
+	// against the host. Off only for local test servers.
+	bool				verify = true;
+};
+
+struct WsTlsInfo {
+	// Abbreviated handshake from a cached session / ticket.
+	bool		resumed = false;
+	std::string	version;
+	std::string	cipher;
+};
+
+} /* namespace exc */
+} /* namespace wbx */
+
+#endif /* #ifndef EXC__WEBSOCKET_OPTS__HPP */
@@ -3,8 +3,14 @@
 #include <wbx/exc/exc_okx/OKX.hpp>
 #include <wbx/nlohmann/json.hpp>
 #include <string>
+#include <chrono>
+#include <cctype>
+#include <cstring>
+#include <cstdint>
 #include <exception>
+#include <stdexcept>
 #include <cstdio>
+#include <algorithm>
 
 using json = nlohmann::json;
 
@@ -12,112 +18,503 @@ namespace wbx {
 namespace exc {
 namespace exc_OKX {
 
-inline void OKX::handlePubWsChan(void *a)
+inline void OKX::handlePubWsChan(void *a, size_t leg)
 {
 	json &j = *static_cast<json *>(a);
 	const std::string &chan = j["arg"]["channel"];
 
 	if (chan == "mark-price")
-		handlePubWsChanMarkPrice(a);
+		handlePubWsChanPrice(a, leg, "markPx");
 	else if (chan == "tickers")
-		handlePubWsChanTickers(a);
+		handlePubWsChanPrice(a, leg, "last");
 }
 
-inline void OKX::handlePubWsChanMarkPrice(void *a)
+static inline uint64_t nowNs(void)
 {
-	json &j = *static_cast<json *>(a);
+	return std::chrono::duration_cast<std::chrono::nanoseconds>(
+		std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+/*
+ * Fill in the symbol id and name of @pu for @sym, the only lookup of
+ * the symbol per update. With redundant connections every update
+ * arrives once per leg. OKX timestamps have millisecond resolution, so
+ * anything not newer than the last delivered ts of the symbol is a
+ * duplicate.
+ */
+inline bool OKX::trackArrival(std::string_view sym, ExcPriceUpdate *pu, size_t leg)
+{
+	bool hedged = pub_nr_legs_ > 1;
+	std::lock_guard<lp_mutex_t> lock(sym_mtx_);
+	auto it = pub_syms_.find(sym);
+	uint64_t now;
+
+	// Unsubscribed while in flight.
+	if (it == pub_syms_.end())
+		return false;
+
+	SymState &st = it->second;
+
+	pu->symbol_id = st.id;
+	pu->symbol = st.name;
+	if (!hedged && !nr_awaiting_tick_.load(std::memory_order_relaxed))
+		return true;
+
+	now = nowNs();
+	if (!st.first_tick_ns) {
+		st.first_tick_ns = std::max<uint64_t>(now - st.sub_ns, 1);
+		sub_first_tick_.record(st.first_tick_ns);
+		nr_awaiting_tick_--;
+	}
+
+	if (!hedged)
+		return true;
+
+	if (pu->ts <= st.last_ts) {
+		nr_duplicates_++;
+		return false;
+	}
 
-	if (!j["data"].is_array())
+	st.last_ts = pu->ts;
+	pub_legs_[leg].nr_first++;
+	return true;
+}
+
+/*
+ * A subscription was answered for @symbol: confirmed if @err is null,
+ * rejected otherwise. Requests that got all their answers are moved to
+ * @done. pub_mtx_ held.
+ */
+void OKX::__subAnswered(const std::string &symbol, const std::string *err,
+			std::vector<std::shared_ptr<SubRequest>> *done)
+{
+	if (err) {
+		auto it = pub_subs_.find(symbol);
+
+		// Rejected symbols are not replayed on reconnect.
+		if (it != pub_subs_.end()) {
+			pub_shard_subs_[it->second]--;
+			pub_subs_.erase(it);
+		}
+	}
+
+	{
+		std::lock_guard<lp_mutex_t> lock(sym_mtx_);
+		auto it = pub_syms_.find(symbol);
+
+		if (it != pub_syms_.end()) {
+			if (!err) {
+				it->second.acked = true;
+			} else {
+				if (!it->second.first_tick_ns)
+					nr_awaiting_tick_--;
+				pub_syms_.erase(it);
+			}
+		}
+	}
+
+	auto it = pub_sub_waiters_.find(symbol);
+	if (it == pub_sub_waiters_.end())
 		return;
 
-	for (const auto &d : j["data"]) {
-		if (!d["instId"].is_string() || !d["markPx"].is_string())
-			continue;
+	for (auto &req : it->second) {
+		if (err)
+			req->res.failed.emplace_back(symbol, *err);
+		else
+			req->res.ok.push_back(symbol);
 
-		struct ExcPriceUpdate pu;
+		if (!--req->nr_left)
+			done->push_back(req);
+	}
+
+	pub_sub_waiters_.erase(it);
+}
+
+static inline bool isInstIdChar(char c)
+{
+	return isalnum((unsigned char)c) || c == '-' || c == '_';
+}
+
+// @msg names @sym as a whole instId, not as part of a longer one.
+static bool msgNamesInstId(const std::string &msg, const std::string &sym)
+{
+	size_t pos, end;
+
+	for (pos = msg.find(sym); pos != std::string::npos; pos = msg.find(sym, pos + 1)) {
+		end = pos + sym.size();
+		if ((!pos || !isInstIdChar(msg[pos - 1])) &&
+		    (end == msg.size() || !isInstIdChar(msg[end])))
+			return true;
+	}
+
+	return false;
+}
+
+/*
+ * Subscribe acks name their symbol. Errors only carry the id of the
+ * request, and the symbol in the message text when it was the cause.
+ */
+inline void OKX::handlePubWsEvent(void *a)
+{
+	json &j = *static_cast<json *>(a);
+	std::vector<std::shared_ptr<SubRequest>> done;
+	std::vector<std::string> rejected;
+	const std::string &ev = j["event"];
+	uint64_t id = 0;
+
+	if (j.contains("id") && j["id"].is_string())
+		id = strtoull(j["id"].get<std::string>().c_str(), nullptr, 10);
+
+	{
+		std::lock_guard<lp_mutex_t> lock(pub_mtx_);
+		auto it_id = pub_sub_ids_.find(id);
+
+		if (ev == "subscribe" && j["arg"]["instId"].is_string()) {
+			const std::string &sym = j["arg"]["instId"];
+
+			if (it_id != pub_sub_ids_.end()) {
+				auto &syms = it_id->second;
+
+				syms.erase(std::remove(syms.begin(), syms.end(), sym), syms.end());
+				if (syms.empty())
+					pub_sub_ids_.erase(it_id);
+			}
+
+			__subAnswered(sym, nullptr, &done);
+		} else if (ev == "error") {
+			std::string msg = j.value("code", "") + ": " + j.value("msg", "");
+			std::vector<std::string> failed;
+
+			nr_sub_errors_++;
+			if (it_id == pub_sub_ids_.end())
+				return;
+
+			for (const auto &sym : it_id->second) {
+				if (msgNamesInstId(msg, sym))
+					failed.push_back(sym);
+			}
+
+			// Not attributable, the whole message failed.
+			if (failed.empty())
+				failed.swap(it_id->second);
 
-		pu.symbol = d["instId"];
-		pu.price = d["markPx"];
-		pu.ts = std::stoul(d["ts"].get<std::string>());
-		invokePriceUpdateCb(pu);
+			for (const auto &sym : failed) {
+				auto &syms = it_id->second;
+
+				syms.erase(std::remove(syms.begin(), syms.end(), sym), syms.end());
+				__subAnswered(sym, &msg, &done);
+				rejected.push_back(sym);
+			}
+
+			if (it_id->second.empty())
+				pub_sub_ids_.erase(it_id);
+		}
 	}
+
+	if (!rejected.empty())
+		subRejected(rejected);
+
+	for (auto &req : done)
+		req->done(req->res);
+}
+
+/*
+ * Price and timestamp of one element of a push's "data" array, the price
+ * taken from @field. @sym and @pu->raw point into @d.
+ */
+static inline bool parsePushPrice(const json &d, const char *field,
+				  std::string_view *sym, ExcPriceUpdate *pu)
+{
+	uint32_t ts_scale;
+
+	auto it_sym = d.find("instId");
+	auto it_px = d.find(field);
+	auto it_ts = d.find("ts");
+	if (it_sym == d.end() || it_px == d.end() || it_ts == d.end() ||
+	    !it_sym->is_string() || !it_px->is_string() || !it_ts->is_string())
+		return false;
+
+	const std::string &px = it_px->get_ref<const std::string &>();
+	if (!parseFixed(px, &pu->price, &pu->scale))
+		return false;
+
+	if (!parseFixed(it_ts->get_ref<const std::string &>(), &pu->ts, &ts_scale) ||
+	    ts_scale)
+		return false;
+
+	*sym = it_sym->get_ref<const std::string &>();
+	pu->raw = px;
+	return true;
 }
 
-inline void OKX::handlePubWsChanTickers(void *a)
+inline void OKX::handlePubWsChanPrice(void *a, size_t leg, const char *field)
 {
 	json &j = *static_cast<json *>(a);
+	std::string_view sym;
 
-	if (!j["data"].is_array())
+	auto it = j.find("data");
+	if (it == j.end() || !it->is_array())
 		return;
 
-	for (const auto &d : j["data"]) {
-		if (!d["instId"].is_string() || !d["last"].is_string())
+	for (const auto &d : *it) {
+		struct ExcPriceUpdate pu;
+
+		if (!parsePushPrice(d, field, &sym, &pu))
 			continue;
 
-		struct ExcPriceUpdate pu;
+		if (trackArrival(sym, &pu, leg))
+			invokePriceUpdateCb(pu);
+	}
+}
+
+struct OKX::Probe {
+	WebsocketSession	*ws_sess = nullptr;
+	size_t			idx = 0;
+	uint64_t		start_ns = 0;
+	uint64_t		ping_ns = 0;
+	uint64_t		handshake_ns = 0;
+	bool			done = false;
+};
+
+inline size_t OKX::findPubLeg(WebsocketSession *ws_sess, bool *is_next)
+{
+	size_t i;
+
+	for (i = 0; i < pub_legs_.size(); i++) {
+		if (pub_legs_[i].ws_sess == ws_sess) {
+			*is_next = false;
+			return i;
+		}
 
-		pu.symbol = d["instId"];
-		pu.price = d["last"];
-		pu.ts = std::stoul(d["ts"].get<std::string>());
-		invokePriceUpdateCb(pu);
+		if (pub_legs_[i].next == ws_sess) {
+			*is_next = true;
+			return i;
+		}
 	}
+
+	return SIZE_MAX;
 }
 
-inline void OKX::handlePubWsOnWsConnect(void)
+inline void OKX::handlePubWsOnWsConnect(WebsocketSession *ws_sess)
 {
-	ws_pub_started_ = true;
+	std::vector<std::string> symbols;
+	bool is_next;
+	size_t leg;
+
+	leg = findPubLeg(ws_sess, &is_next);
+	if (leg == SIZE_MAX)
+		return;
+
+	{
+		std::lock_guard<lp_mutex_t> lock(pub_mtx_);
+		PubLeg &l = pub_legs_[leg];
+		SubPacer &p = is_next ? l.next_pacer : l.pacer;
+
+		if (is_next) {
+			l.next_ready = true;
+		} else {
+			ws_pub_started_ = true;
+			l.up = true;
+			l.last_data_ns = nowNs();
+		}
+
+		// Whatever was pending targeted the previous connection.
+		p.q.clear();
+		symbols = __shardSubs(l.shard);
+		if (!symbols.empty()) {
+			__queuePubReq(p, "subscribe", symbols);
+			__kickPubDrain();
+		}
+
+		if (!is_next)
+			return;
+	}
+
+	// Nothing to wait for, switch right away.
+	if (symbols.empty())
+		completeMigratePub(leg);
 }
 
-inline void OKX::handlePubWsOnWsWrite(size_t len)
+inline void OKX::handlePubWsOnWsWrite(WebsocketSession *ws_sess, size_t len)
 {
-	wss_pub_->read();
+	ws_sess->read();
 	(void)len;
 }
 
-inline size_t OKX::handlePubWsOnWsRead(const char *data, size_t len)
+inline size_t OKX::handlePubWsOnWsRead(WebsocketSession *ws_sess, const char *data,
+				       size_t len)
 {
+	bool is_next;
+	size_t leg;
+
+	leg = findPubLeg(ws_sess, &is_next);
+	if (leg == SIZE_MAX)
+		return len;
+
 	try {
 		std::string str(data, len);
 		json j = json::parse(str);
-		handlePubWsChan(&j);
-		wss_pub_->read();
+
+		if (j.contains("event")) {
+			handlePubWsEvent(&j);
+			j = nullptr;
+		}
+
+		/*
+		 * The connection being migrated to takes over with its first
+		 * data push, from then on the old one is gone.
+		 */
+		if (is_next && !j.is_null()) {
+			if (j.contains("data"))
+				completeMigratePub(leg);
+			else
+				j = nullptr;
+		}
+
+		if (!j.is_null()) {
+			if (stale_budget_ms_)
+				pub_legs_[leg].last_data_ns = nowNs();
+			handlePubWsChan(&j, leg);
+		}
 	} catch (const std::exception &e) {
 	}
 
+	ws_sess->read();
 	return len;
 }
 
-inline void OKX::handlePubWsOnWsClose(void)
+inline void OKX::handlePubWsOnWsClose(WebsocketSession *ws_sess)
 {
+	(void)ws_sess;
 }
 
-inline void OKX::startPubWs(void)
+inline void OKX::handlePubWsOnWsConnErr(WebsocketSession *ws_sess)
 {
-	if (wss_pub_)
+	bool is_next;
+	size_t leg;
+
+	leg = findPubLeg(ws_sess, &is_next);
+	if (leg == SIZE_MAX)
 		return;
 
-	wss_pub_ = ws_->createSession("wspri.okx.com", 8443, "/ws/v5/ipublic");
-	wss_pub_->setOnConnect([this](WebsocketSession *ws_sess) {
-		handlePubWsOnWsConnect();
-		(void)ws_sess;
+	{
+		std::lock_guard<lp_mutex_t> lock(pub_mtx_);
+		PubLeg &l = pub_legs_[leg];
+
+		// The session reconnects by itself.
+		if (!is_next) {
+			l.up = false;
+			return;
+		}
+
+		l.next = nullptr;
+		l.next_ready = false;
+		l.next_pacer.q.clear();
+	}
+
+	ws_->destroySession(ws_sess);
+}
+
+WebsocketSession *OKX::createPubSession(const OKXEndpoint &ep)
+{
+	WebsocketSession *ws_sess;
+
+	ws_sess = ws_->createSession(ep.host, ep.port, ep.uri);
+	ws_sess->setStandby(pub_standby_);
+	ws_sess->setHeartbeat(pub_hb_);
+	ws_sess->setQueueOpts(pub_queue_);
+	ws_sess->setReconnect(true);
+	ws_sess->setOnConnect([this](WebsocketSession *ws_sess) {
+		handlePubWsOnWsConnect(ws_sess);
 	});
 
-	wss_pub_->setOnWrite([this](WebsocketSession *ws_sess, size_t len) {
-		handlePubWsOnWsWrite(len);
-		(void)ws_sess;
+	ws_sess->setOnWrite([this](WebsocketSession *ws_sess, size_t len) {
+		handlePubWsOnWsWrite(ws_sess, len);
 	});
 
-	wss_pub_->setOnRead([this](WebsocketSession *ws_sess, const char *data, size_t len) {
-		(void)ws_sess;
-		return handlePubWsOnWsRead(data, len);
+	ws_sess->setOnRead(WsOnReadRef_t::bind<&OKX::handlePubWsOnWsRead>(this));
+
+	ws_sess->setOnClose([this](WebsocketSession *ws_sess) {
+		handlePubWsOnWsClose(ws_sess);
 	});
 
-	wss_pub_->setOnClose([this](WebsocketSession *ws_sess) {
-		handlePubWsOnWsClose();
-		(void)ws_sess;
+	ws_sess->setOnConnErr([this](WebsocketSession *ws_sess, int code,
+				     const char *msg) {
+		handlePubWsOnWsConnErr(ws_sess);
+		(void)code;
+		(void)msg;
 	});
 
-	wss_pub_->run();
+	return ws_sess;
+}
+
+/*
+ * Open the connections of the next shard: pub_nr_legs_ of them, spread
+ * over the endpoints. pub_mtx_ held.
+ */
+void OKX::__addPubShard(void)
+{
+	ConnClass &cc = getConnClass(OKXConnClass::Public);
+	size_t i;
+
+	for (i = 0; i < pub_nr_legs_; i++) {
+		PubLeg leg;
+
+		leg.shard = pub_nr_shards_;
+		leg.ep = i % cc.eps.size();
+		leg.pacer.tb.setRate(sub_opts_.rate_per_s, sub_opts_.burst);
+		leg.next_pacer.tb.setRate(sub_opts_.rate_per_s, sub_opts_.burst);
+		leg.ws_sess = createPubSession(cc.eps[leg.ep].ep);
+		pub_legs_.push_back(std::move(leg));
+		pub_legs_.back().ws_sess->run();
+	}
+
+	pub_nr_shards_++;
+}
+
+// Runs on the io thread, where pub_legs_ may grow.
+void OKX::growPub(void)
+{
+	std::lock_guard<lp_mutex_t> lock(pub_mtx_);
+
+	while (pub_nr_shards_ < pub_shard_subs_.size())
+		__addPubShard();
+}
+
+inline void OKX::startPubWs(void)
+{
+	ConnClass &cc = getConnClass(OKXConnClass::Public);
+
+	if (!pub_legs_.empty())
+		return;
+
+	{
+		std::lock_guard<lp_mutex_t> lock(pub_mtx_);
+
+		if (pub_shard_subs_.empty())
+			pub_shard_subs_.push_back(0);
+
+		while (pub_nr_shards_ < pub_shard_subs_.size())
+			__addPubShard();
+	}
+
+	if (probe_opts_.interval_ms && cc.eps.size() > 1) {
+		std::weak_ptr<bool> alive = alive_;
+
+		ws_->post([this, alive]() {
+			if (alive.lock())
+				probeEndpoints();
+		});
+	}
+
+	if (stale_budget_ms_) {
+		std::weak_ptr<bool> alive = alive_;
+
+		ws_->runAfter(stale_budget_ms_, [this, alive]() {
+			if (alive.lock())
+				checkStale();
+		});
+	}
 }
 
 inline void OKX::startPriWs(void)
@@ -125,6 +522,407 @@ inline void OKX::startPriWs(void)
 	(void)wss_pri_;
 }
 
+/*
+ * Open a throwaway connection to every public endpoint and time the
+ * websocket handshake and a "ping" -> "pong" round trip on it. Runs on
+ * the io thread; the next round is scheduled once all probes are done.
+ */
+void OKX::probeEndpoints(void)
+{
+	ConnClass &cc = getConnClass(OKXConnClass::Public);
+	std::weak_ptr<bool> alive = alive_;
+	size_t i;
+
+	for (i = 0; i < cc.eps.size(); i++) {
+		const OKXEndpoint &ep = cc.eps[i].ep;
+		auto pr = std::make_shared<Probe>();
+
+		pr->idx = i;
+		pr->start_ns = nowNs();
+		pr->ws_sess = ws_->createSession(ep.host, ep.port, ep.uri);
+
+		pr->ws_sess->setOnConnect([pr](WebsocketSession *ws_sess) {
+			pr->ping_ns = nowNs();
+			pr->handshake_ns = pr->ping_ns - pr->start_ns;
+			ws_sess->write("ping", 4);
+		});
+
+		pr->ws_sess->setOnWrite([](WebsocketSession *ws_sess, size_t len) {
+			ws_sess->read();
+			(void)len;
+		});
+
+		pr->ws_sess->setOnRead([this, alive, pr](WebsocketSession *ws_sess,
+							 const char *data, size_t len) {
+			if (!alive.lock())
+				return len;
+
+			if (len == 4 && !memcmp(data, "pong", 4))
+				finishProbe(pr, true);
+			else
+				ws_sess->read();
+			return len;
+		});
+
+		pr->ws_sess->setOnConnErr([this, alive, pr](WebsocketSession *ws_sess,
+							    int code, const char *msg) {
+			if (alive.lock())
+				finishProbe(pr, false);
+			(void)ws_sess;
+			(void)code;
+			(void)msg;
+		});
+
+		nr_probes_running_++;
+		pr->ws_sess->run();
+		ws_->runAfter(probe_opts_.timeout_ms, [this, alive, pr]() {
+			if (alive.lock())
+				finishProbe(pr, false);
+		});
+	}
+}
+
+void OKX::finishProbe(const std::shared_ptr<Probe> &pr, bool ok)
+{
+	if (pr->done)
+		return;
+
+	pr->done = true;
+
+	{
+		std::lock_guard<lp_mutex_t> lock(pub_mtx_);
+		EndpointState &es = getConnClass(OKXConnClass::Public).eps[pr->idx];
+		uint64_t w = probe_opts_.ewma_pct;
+
+		es.nr_probes++;
+		es.last_ok = ok;
+		if (ok) {
+			uint64_t rtt = nowNs() - pr->ping_ns;
+
+			es.handshake_ns = pr->handshake_ns;
+			es.rtt_ns = es.rtt_ns ? (rtt * w + es.rtt_ns * (100 - w)) / 100 : rtt;
+		} else {
+			es.nr_failures++;
+		}
+	}
+
+	ws_->destroySession(pr->ws_sess);
+
+	if (--nr_probes_running_)
+		return;
+
+	maybeMigratePub();
+	if (probe_opts_.interval_ms) {
+		std::weak_ptr<bool> alive = alive_;
+
+		ws_->runAfter(probe_opts_.interval_ms, [this, alive]() {
+			if (alive.lock())
+				probeEndpoints();
+		});
+	}
+}
+
+/*
+ * Move the slowest leg to the fastest endpoint no leg is using yet.
+ * Make-before-break: the new connection is established and subscribed
+ * next to the current one, which keeps delivering until the new one
+ * pushes its first data. One migration at a time.
+ */
+void OKX::maybeMigratePub(void)
+{
+	ConnClass &cc = getConnClass(OKXConnClass::Public);
+	std::lock_guard<lp_mutex_t> lock(pub_mtx_);
+	size_t i, j, cand = SIZE_MAX, cand_ep = SIZE_MAX;
+	uint64_t cand_rtt = 0;
+
+	if (pub_legs_.empty())
+		return;
+
+	if (nowNs() - pub_subs_changed_ns_ < probe_opts_.quiet_ms * 1000000ull)
+		return;
+
+	for (const auto &leg : pub_legs_) {
+		if (leg.next)
+			return;
+	}
+
+	/*
+	 * Legs of one shard stay on distinct endpoints. Pick the slowest
+	 * leg that has a sufficiently faster endpoint left in its shard.
+	 */
+	for (i = 0; i < pub_legs_.size(); i++) {
+		const EndpointState &es = cc.eps[pub_legs_[i].ep];
+		uint64_t rtt = es.last_ok ? es.rtt_ns : UINT64_MAX;
+		std::vector<bool> used(cc.eps.size(), false);
+		size_t best = SIZE_MAX;
+
+		for (const auto &leg : pub_legs_) {
+			if (leg.shard == pub_legs_[i].shard)
+				used[leg.ep] = true;
+		}
+
+		for (j = 0; j < cc.eps.size(); j++) {
+			if (used[j] || !cc.eps[j].last_ok)
+				continue;
+			if (best == SIZE_MAX || cc.eps[j].rtt_ns < cc.eps[best].rtt_ns)
+				best = j;
+		}
+
+		if (best == SIZE_MAX)
+			continue;
+
+		if (rtt != UINT64_MAX &&
+		    cc.eps[best].rtt_ns * (100 + probe_opts_.switch_margin_pct) >= rtt * 100)
+			continue;
+
+		if (cand == SIZE_MAX || rtt > cand_rtt) {
+			cand = i;
+			cand_ep = best;
+			cand_rtt = rtt;
+		}
+	}
+
+	if (cand == SIZE_MAX)
+		return;
+
+	PubLeg &leg = pub_legs_[cand];
+	leg.next_ep = cand_ep;
+	leg.next_ready = false;
+	leg.next_pacer.q.clear();
+	leg.next = createPubSession(cc.eps[cand_ep].ep);
+	leg.next->run();
+}
+
+void OKX::completeMigratePub(size_t leg)
+{
+	WebsocketSession *old;
+
+	{
+		std::lock_guard<lp_mutex_t> lock(pub_mtx_);
+		PubLeg &l = pub_legs_[leg];
+
+		old = l.ws_sess;
+		l.ws_sess = l.next;
+		l.ep = l.next_ep;
+		l.next = nullptr;
+		l.next_ready = false;
+		l.up = true;
+		l.last_data_ns = nowNs();
+		std::swap(l.pacer, l.next_pacer);
+		l.next_pacer.q.clear();
+	}
+
+	ws_->destroySession(old);
+}
+
+/*
+ * Runs on the io thread every quarter of the stale budget. A connection
+ * that is up with subscriptions but pushed nothing while it still
+ * answers pings means the server stopped pushing; a fresh connection
+ * and subscription usually brings it back. Tickers only push on
+ * change, so a single quiet symbol says nothing.
+ */
+void OKX::checkStale(void)
+{
+	uint64_t now = nowNs();
+	uint64_t budget_ns = stale_budget_ms_ * 1000000ull;
+	std::vector<WebsocketSession *> sessions;
+	std::weak_ptr<bool> alive = alive_;
+
+	{
+		std::lock_guard<lp_mutex_t> lock(pub_mtx_);
+
+		for (auto &l : pub_legs_) {
+			// New subscriptions get a full budget too.
+			uint64_t last = std::max(l.last_data_ns, pub_subs_changed_ns_);
+
+			if (!l.up || !pub_shard_subs_[l.shard] || now - last < budget_ns)
+				continue;
+
+			l.last_data_ns = now;
+			sessions.push_back(l.ws_sess);
+		}
+
+		nr_stale_reconnects_ += sessions.size();
+	}
+
+	for (auto *ws_sess : sessions)
+		ws_sess->reconnect();
+
+	ws_->runAfter(std::max<uint64_t>(stale_budget_ms_ / 4, 1), [this, alive]() {
+		if (alive.lock())
+			checkStale();
+	});
+}
+
+// First shard below the per-connection cap, a new one if all are full.
+inline size_t OKX::__pickPubShard(void)
+{
+	size_t i;
+
+	for (i = 0; i < pub_shard_subs_.size(); i++) {
+		if (!sub_opts_.max_subs_per_conn ||
+		    pub_shard_subs_[i] < sub_opts_.max_subs_per_conn)
+			return i;
+	}
+
+	pub_shard_subs_.push_back(0);
+	return i;
+}
+
+std::vector<std::string> OKX::__shardSubs(size_t shard)
+{
+	std::vector<std::string> ret;
+
+	for (const auto &it : pub_subs_) {
+		if (it.second == shard)
+			ret.push_back(it.first);
+	}
+
+	return ret;
+}
+
+/*
+ * Append @op for @symbols to @p, split into messages that stay below
+ * sub_opts_.max_msg_bytes. pub_mtx_ held.
+ */
+void OKX::__queuePubReq(SubPacer &p, const char *op,
+			const std::vector<std::string> &symbols)
+{
+	// {"args":[],"id":"<20 digits>","op":"unsubscribe"} and
+	// {"channel":"tickers","instId":""},
+	constexpr static size_t envelope_len = 60;
+	constexpr static size_t arg_len = 36;
+	bool is_sub = !strcmp(op, "subscribe");
+	size_t i = 0, first, len;
+	uint64_t id;
+
+	while (i < symbols.size()) {
+		SubReq req;
+		json j;
+
+		j["op"] = op;
+		j["args"] = json::array();
+		len = envelope_len;
+		for (first = i; i < symbols.size(); i++) {
+			json sub;
+
+			len += arg_len + symbols[i].size();
+			if (i > first && len > sub_opts_.max_msg_bytes)
+				break;
+
+			sub["channel"] = "tickers";
+			sub["instId"] = symbols[i];
+			j["args"].push_back(sub);
+		}
+
+		// Errors are matched to their request by id.
+		if (is_sub) {
+			id = pub_next_req_id_++;
+			j["id"] = std::to_string(id);
+			pub_sub_ids_[id].assign(symbols.begin() + first, symbols.begin() + i);
+
+			// Answers of dead connections never come.
+			while (pub_sub_ids_.size() > 4096)
+				pub_sub_ids_.erase(pub_sub_ids_.begin());
+		}
+
+		req.msg = j.dump();
+		req.meta.cls = WsMsgClass::Subscription;
+		if (i - first == 1) {
+			req.meta.key = "tickers:" + symbols[first];
+			req.meta.op = is_sub ? 1 : -1;
+		}
+
+		p.q.push_back(std::move(req));
+	}
+}
+
+// Queue @op on every live connection of @shard. pub_mtx_ held.
+void OKX::__queueShardReq(size_t shard, const char *op,
+			  const std::vector<std::string> &symbols)
+{
+	for (auto &leg : pub_legs_) {
+		if (leg.shard != shard)
+			continue;
+
+		// A connection that is not up replays the shard on connect.
+		if (leg.up)
+			__queuePubReq(leg.pacer, op, symbols);
+		if (leg.next && leg.next_ready)
+			__queuePubReq(leg.next_pacer, op, symbols);
+	}
+}
+
+inline void OKX::__drainPacer(WebsocketSession *ws_sess, SubPacer &p,
+			      uint64_t now, uint64_t *wait_ns)
+{
+	while (!p.q.empty()) {
+		if (!p.tb.take(now)) {
+			*wait_ns = std::min(*wait_ns, p.tb.waitNs(now));
+			return;
+		}
+
+		/*
+		 * The send queue of the connection is full. The request
+		 * never left, so keep it and its token and retry on the
+		 * next drain tick.
+		 */
+		if (ws_sess->write(p.q.front().msg, p.q.front().meta) < 0) {
+			p.tb.giveBack();
+			*wait_ns = 0;
+			return;
+		}
+
+		p.q.pop_front();
+	}
+}
+
+// pub_mtx_ held.
+inline void OKX::__kickPubDrain(void)
+{
+	std::weak_ptr<bool> alive = alive_;
+
+	// Before start() the connections replay everything on connect.
+	if (pub_drain_pending_ || pub_legs_.empty())
+		return;
+
+	pub_drain_pending_ = true;
+	ws_->post([this, alive]() {
+		if (alive.lock())
+			drainPub();
+	});
+}
+
+/*
+ * Send what the rate limits of the connections allow, runs on the io
+ * thread until all pacers are empty.
+ */
+void OKX::drainPub(void)
+{
+	std::lock_guard<lp_mutex_t> lock(pub_mtx_);
+	uint64_t wait_ns = UINT64_MAX;
+	uint64_t now = nowNs();
+	std::weak_ptr<bool> alive = alive_;
+
+	pub_drain_pending_ = false;
+	for (auto &leg : pub_legs_) {
+		if (leg.up)
+			__drainPacer(leg.ws_sess, leg.pacer, now, &wait_ns);
+		if (leg.next && leg.next_ready)
+			__drainPacer(leg.next, leg.next_pacer, now, &wait_ns);
+	}
+
+	if (wait_ns == UINT64_MAX)
+		return;
+
+	pub_drain_pending_ = true;
+	ws_->runAfter(wait_ns / 1000000 + 1, [this, alive]() {
+		if (alive.lock())
+			drainPub();
+	});
+}
+
 void OKX::__listenPriceUpdate(const std::string &symbol)
 {
 	__listenPriceUpdateBatch({symbol});
@@ -135,36 +933,359 @@ void OKX::__unlistenPriceUpdate(const std::string &symbol)
 	__unlistenPriceUpdateBatch({symbol});
 }
 
-void OKX::__listenPriceUpdateBatch(const std::vector<std::string> &symbols)
+// pub_mtx_ held.
+void OKX::__listenPub(const std::vector<std::string> &symbols)
 {
-	json j;
+	std::vector<std::vector<std::string>> by_shard;
+	uint64_t now = nowNs();
+	size_t i;
 
-	j["op"] = "subscribe";
-	j["args"] = json::array();
 	for (const auto &s : symbols) {
-		json sub;
-		sub["channel"] = "tickers";
-		sub["instId"] = s;
-		j["args"].push_back(sub);
+		if (pub_subs_.count(s))
+			continue;
+
+		i = __pickPubShard();
+		pub_subs_[s] = i;
+		pub_shard_subs_[i]++;
+		if (by_shard.size() <= i)
+			by_shard.resize(i + 1);
+		by_shard[i].push_back(s);
+	}
+	pub_subs_changed_ns_ = now;
+
+	{
+		std::lock_guard<lp_mutex_t> slock(sym_mtx_);
+
+		for (const auto &s : symbols) {
+			auto ins = pub_syms_.emplace(s, SymState());
+			SymState &st = ins.first->second;
+
+			if (ins.second) {
+				st.id = internSymbol(s, &st.name);
+				st.sub_ns = now;
+				nr_awaiting_tick_++;
+			}
+		}
+	}
+
+	for (i = 0; i < by_shard.size(); i++) {
+		if (!by_shard[i].empty())
+			__queueShardReq(i, "subscribe", by_shard[i]);
+	}
+
+	// New shards get their connections on the io thread.
+	if (!pub_legs_.empty() && pub_shard_subs_.size() > pub_nr_shards_) {
+		std::weak_ptr<bool> alive = alive_;
+
+		ws_->post([this, alive]() {
+			if (alive.lock())
+				growPub();
+		});
 	}
 
-	wss_pub_->write(j.dump());
+	__kickPubDrain();
+}
+
+void OKX::__listenPriceUpdateBatch(const std::vector<std::string> &symbols)
+{
+	std::lock_guard<lp_mutex_t> lock(pub_mtx_);
+	__listenPub(symbols);
+}
+
+void OKX::__listenPriceUpdateBatchAck(const std::vector<std::string> &symbols,
+				      SubDoneCb_t done)
+{
+	auto req = std::make_shared<SubRequest>();
+
+	req->done = std::move(done);
+	{
+		std::lock_guard<lp_mutex_t> lock(pub_mtx_);
+
+		{
+			std::lock_guard<lp_mutex_t> slock(sym_mtx_);
+
+			for (const auto &s : symbols) {
+				auto it = pub_syms_.find(s);
+
+				if (std::find(req->symbols.begin(), req->symbols.end(), s) !=
+				    req->symbols.end())
+					continue;
+
+				req->symbols.push_back(s);
+				if (it != pub_syms_.end() && it->second.acked) {
+					req->res.ok.push_back(s);
+					continue;
+				}
+
+				pub_sub_waiters_[s].push_back(req);
+				req->nr_left++;
+			}
+		}
+
+		__listenPub(symbols);
+	}
+
+	if (!req->nr_left) {
+		if (req->done)
+			req->done(req->res);
+		return;
+	}
+
+	if (ws_) {
+		std::weak_ptr<bool> alive = alive_;
+
+		ws_->runAfter(sub_opts_.ack_timeout_ms, [this, alive, req]() {
+			if (alive.lock())
+				expireSubRequest(req);
+		});
+	}
+}
+
+// Fail what is still unanswered of @req.
+void OKX::expireSubRequest(const std::shared_ptr<SubRequest> &req)
+{
+	static const std::string timeout = "timeout";
+
+	{
+		std::lock_guard<lp_mutex_t> lock(pub_mtx_);
+
+		if (!req->nr_left)
+			return;
+
+		for (const auto &s : req->symbols) {
+			auto it = pub_sub_waiters_.find(s);
+			if (it == pub_sub_waiters_.end())
+				continue;
+
+			auto &reqs = it->second;
+			auto pos = std::find(reqs.begin(), reqs.end(), req);
+			if (pos == reqs.end())
+				continue;
+
+			reqs.erase(pos);
+			if (reqs.empty())
+				pub_sub_waiters_.erase(it);
+
+			req->res.failed.emplace_back(s, timeout);
+			req->nr_left--;
+		}
+	}
+
+	if (req->done)
+		req->done(req->res);
 }
 
 void OKX::__unlistenPriceUpdateBatch(const std::vector<std::string> &symbols)
 {
-	json j;
+	std::lock_guard<lp_mutex_t> lock(pub_mtx_);
+	std::vector<std::vector<std::string>> by_shard(pub_shard_subs_.size());
+	size_t i;
+
+	for (const auto &s : symbols) {
+		auto it = pub_subs_.find(s);
+		if (it == pub_subs_.end())
+			continue;
+
+		i = it->second;
+		pub_shard_subs_[i]--;
+		by_shard[i].push_back(s);
+		pub_subs_.erase(it);
+	}
+	pub_subs_changed_ns_ = nowNs();
 
-	j["op"] = "unsubscribe";
-	j["args"] = json::array();
+	for (i = 0; i < by_shard.size(); i++) {
+		if (!by_shard[i].empty())
+			__queueShardReq(i, "unsubscribe", by_shard[i]);
+	}
+	__kickPubDrain();
+
+	std::lock_guard<lp_mutex_t> slock(sym_mtx_);
 	for (const auto &s : symbols) {
-		json sub;
-		sub["channel"] = "tickers";
-		sub["instId"] = s;
-		j["args"].push_back(sub);
+		auto it = pub_syms_.find(s);
+		if (it == pub_syms_.end())
+			continue;
+
+		if (!it->second.first_tick_ns)
+			nr_awaiting_tick_--;
+		pub_syms_.erase(it);
+	}
+}
+
+void OKX::setEndpoints(OKXConnClass cls, const std::vector<OKXEndpoint> &eps)
+{
+	ConnClass &cc = getConnClass(cls);
+	std::lock_guard<lp_mutex_t> lock(pub_mtx_);
+
+	if (eps.empty())
+		throw std::runtime_error("Endpoint list must not be empty");
+	if (!pub_legs_.empty() || wss_pri_)
+		throw std::runtime_error("Endpoints must be set before start()");
+
+	cc.eps.clear();
+	for (const auto &ep : eps) {
+		EndpointState es;
+		es.ep = ep;
+		cc.eps.push_back(es);
 	}
+}
+
+void OKX::setProbeOpts(const OKXProbeOpts &opts)
+{
+	if (opts.ewma_pct > 100)
+		throw std::runtime_error("ewma_pct must be at most 100");
 
-	wss_pub_->write(j.dump());
+	probe_opts_ = opts;
+}
+
+std::vector<OKXEndpointStats> OKX::getEndpointStats(OKXConnClass cls)
+{
+	ConnClass &cc = getConnClass(cls);
+	std::lock_guard<lp_mutex_t> lock(pub_mtx_);
+	std::vector<OKXEndpointStats> ret;
+	size_t i;
+
+	for (i = 0; i < cc.eps.size(); i++) {
+		const EndpointState &es = cc.eps[i];
+		bool active = false;
+
+		if (cls == OKXConnClass::Public) {
+			for (const auto &leg : pub_legs_)
+				active |= (leg.ep == i);
+		}
+
+		ret.push_back({ es.ep, active, es.handshake_ns, es.rtt_ns,
+				es.nr_probes, es.nr_failures });
+	}
+
+	return ret;
+}
+
+void OKX::setPubRedundancy(size_t nr_legs)
+{
+	std::lock_guard<lp_mutex_t> lock(pub_mtx_);
+
+	if (!nr_legs)
+		throw std::runtime_error("Invalid number of connections");
+	if (!pub_legs_.empty())
+		throw std::runtime_error("Redundancy must be set before start()");
+
+	pub_nr_legs_ = nr_legs;
+}
+
+void OKX::setSubOpts(const OKXSubOpts &opts)
+{
+	std::lock_guard<lp_mutex_t> lock(pub_mtx_);
+
+	if (opts.rate_per_s <= 0 || !opts.burst)
+		throw std::runtime_error("Invalid subscription rate");
+	if (!pub_legs_.empty())
+		throw std::runtime_error("Subscription options must be set before start()");
+
+	sub_opts_ = opts;
+}
+
+bool OKX::getSubInfo(const std::string &symbol, OKXSubInfo *info)
+{
+	std::lock_guard<lp_mutex_t> lock(sym_mtx_);
+	auto it = pub_syms_.find(symbol);
+
+	if (it == pub_syms_.end())
+		return false;
+
+	info->acked = it->second.acked;
+	info->first_tick_ns = it->second.first_tick_ns;
+	return true;
+}
+
+uint64_t OKX::getNrSubErrors(void)
+{
+	std::lock_guard<lp_mutex_t> lock(pub_mtx_);
+	return nr_sub_errors_;
+}
+
+size_t OKX::getNrPubConnections(void)
+{
+	std::lock_guard<lp_mutex_t> lock(pub_mtx_);
+	return pub_legs_.size();
+}
+
+void OKX::setPubStandby(bool enable)
+{
+	std::lock_guard<lp_mutex_t> lock(pub_mtx_);
+
+	if (!pub_legs_.empty())
+		throw std::runtime_error("Standby must be set before start()");
+
+	pub_standby_ = enable;
+}
+
+OKXHedgeStats OKX::getHedgeStats(void)
+{
+	std::lock_guard<lp_mutex_t> lock(pub_mtx_);
+	std::lock_guard<lp_mutex_t> slock(sym_mtx_);
+	OKXHedgeStats ret;
+
+	ret.nr_duplicates = nr_duplicates_;
+	for (const auto &leg : pub_legs_)
+		ret.leg_first.push_back(leg.nr_first);
+
+	return ret;
+}
+
+void OKX::setPubHeartbeat(const WsHeartbeatOpts &opts)
+{
+	std::lock_guard<lp_mutex_t> lock(pub_mtx_);
+
+	if (!pub_legs_.empty())
+		throw std::runtime_error("Heartbeat must be set before start()");
+
+	pub_hb_ = opts;
+}
+
+const LatencyHistogram &OKX::getPubHeartbeatRtt(size_t leg)
+{
+	std::lock_guard<lp_mutex_t> lock(pub_mtx_);
+
+	if (leg >= pub_legs_.size())
+		throw std::runtime_error("Invalid public connection index");
+
+	return pub_legs_[leg].ws_sess->getHeartbeatRtt();
+}
+
+void OKX::setStaleBudget(uint64_t ms)
+{
+	std::lock_guard<lp_mutex_t> lock(pub_mtx_);
+
+	if (!pub_legs_.empty())
+		throw std::runtime_error("Stale budget must be set before start()");
+
+	stale_budget_ms_ = ms;
+}
+
+void OKX::setPubQueueOpts(const WsQueueOpts &opts)
+{
+	std::lock_guard<lp_mutex_t> lock(pub_mtx_);
+
+	if (!pub_legs_.empty())
+		throw std::runtime_error("Queue options must be set before start()");
+
+	pub_queue_ = opts;
+}
+
+WsQueueStats OKX::getPubQueueStats(size_t leg)
+{
+	std::lock_guard<lp_mutex_t> lock(pub_mtx_);
+
+	if (leg >= pub_legs_.size())
+		throw std::runtime_error("Invalid public connection index");
+
+	return pub_legs_[leg].ws_sess->getQueueStats();
+}
+
+uint64_t OKX::getNrStaleReconnects(void)
+{
+	std::lock_guard<lp_mutex_t> lock(pub_mtx_);
+	return nr_stale_reconnects_;
 }
 
 void OKX::start(void)
@@ -173,8 +1294,25 @@ void OKX::start(void)
 	startPriWs();
 }
 
-OKX::OKX(void) = default;
-OKX::~OKX(void) = default;
+OKX::OKX(void)
+{
+	pub_hb_.interval_ms = 1000;
+	pub_hb_.timeout_ms = 1000;
+	pub_queue_.max_msgs = 1024;
+	setEndpoints(OKXConnClass::Public, {
+		{ "wspri.okx.com", 8443, "/ws/v5/ipublic" },
+		{ "ws.okx.com", 8443, "/ws/v5/public" },
+		{ "wsaws.okx.com", 8443, "/ws/v5/public" },
+	});
+	setEndpoints(OKXConnClass::Private, {
+		{ "ws.okx.com", 8443, "/ws/v5/private" },
+	});
+}
+
+OKX::~OKX(void)
+{
+	stopShards();
+}
 
 } /* namespace exc_OKX */
 } /* namespace exc */
@@ -1,42 +1,323 @@
 // SPDX-License-Identifier: GPL-2.0-only
 
 #include <string>
+#include <vector>
+#include <memory>
 #include <functional>
+#include <unordered_set>
+#include <map>
+#include <deque>
+#include <atomic>
 #include <wbx/exc/ExchangeFoundation.hpp>
+#include <wbx/exc/FlatStrMap.hpp>
+#include <wbx/exc/TokenBucket.hpp>
 
 namespace wbx {
 namespace exc {
 namespace exc_OKX {
 
+enum class OKXConnClass {
+	Public,
+	Private,
+};
+
+struct OKXEndpoint {
+	std::string	host;
+	uint16_t	port = 8443;
+	std::string	uri;
+};
+
+struct OKXProbeOpts {
+	// Time between probe rounds, 0 disables probing and migration.
+	uint64_t	interval_ms = 60000;
+	// A probe without a "pong" within this long counts as a failure.
+	uint64_t	timeout_ms = 5000;
+	// Weight of the newest RTT sample in the moving average, percent.
+	uint32_t	ewma_pct = 30;
+	// Migrate only to an endpoint at least this much faster, percent.
+	uint32_t	switch_margin_pct = 20;
+	// ... and only once the subscription set has not changed for this
+	// long.
+	uint64_t	quiet_ms = 2000;
+};
+
+struct OKXEndpointStats {
+	OKXEndpoint	ep;
+	// In use by a public connection.
+	bool		active;
+	// Connect to websocket handshake of the last successful probe.
+	uint64_t	handshake_ns;
+	// Moving average of "ping" -> "pong", 0 until the first sample.
+	uint64_t	rtt_ns;
+	uint64_t	nr_probes;
+	uint64_t	nr_failures;
+};
+
+struct OKXSubOpts {
+	// Size limit of one (un)subscribe message, larger requests are
+	// split. OKX rejects channel lists over 64 KB.
+	size_t		max_msg_bytes = 60000;
+	// (Un)subscribe messages per second and burst, per connection.
+	// OKX allows 3 requests per second.
+	double		rate_per_s = 3;
+	uint32_t	burst = 3;
+	// Symbols per public connection, further ones are spread over
+	// additional connections. 0 puts everything on one.
+	size_t		max_subs_per_conn = 1000;
+	// Symbols without an answer this long after the request fail
+	// with "timeout".
+	uint64_t	ack_timeout_ms = 10000;
+};
+
+struct OKXSubInfo {
+	// Confirmed by the server.
+	bool		acked;
+	// Subscribe call -> first update, 0 until there was one.
+	uint64_t	first_tick_ns;
+};
+
+struct OKXHedgeStats {
+	uint64_t		nr_duplicates;
+	// Updates delivered first by each public connection.
+	std::vector<uint64_t>	leg_first;
+};
+
 class OKX: public exc::ExchangeFoundation {
 private:
+	struct EndpointState {
+		OKXEndpoint	ep;
+		uint64_t	handshake_ns = 0;
+		uint64_t	rtt_ns = 0;
+		uint64_t	nr_probes = 0;
+		uint64_t	nr_failures = 0;
+		bool		last_ok = false;
+	};
+
+	struct ConnClass {
+		std::vector<EndpointState>	eps;
+	};
+
+	struct Probe;
+
+	struct SubReq {
+		std::string	msg;
+		WsMsgMeta	meta;
+	};
+
+	// (Un)subscribe messages waiting for the rate limit of a connection.
+	struct SubPacer {
+		TokenBucket		tb;
+		std::deque<SubReq>	q;
+	};
+
+	/*
+	 * One public connection carrying the subscriptions of a shard.
+	 * With redundancy each shard has several, each on its own endpoint
+	 * if there are enough of them. @next is the connection this leg is
+	 * being migrated to.
+	 */
+	struct PubLeg {
+		WebsocketSession	*ws_sess = nullptr;
+		size_t			shard = 0;
+		size_t			ep = 0;
+		WebsocketSession	*next = nullptr;
+		bool			next_ready = false;
+		size_t			next_ep = 0;
+		uint64_t		nr_first = 0;
+		// Steady clock of the last data push or (re)connect, for
+		// the stale watchdog. Io thread only.
+		uint64_t		last_data_ns = 0;
+		// Handshaked and not failed since. Every (re)connect
+		// replays the shard's subscriptions.
+		bool			up = false;
+		SubPacer		pacer;
+		SubPacer		next_pacer;
+	};
+
 	bool ws_pub_started_ = false;
 	bool ws_pri_started_ = false;
-	WebsocketSession *wss_pub_ = nullptr;
+
+	// Legs and session pointers are only changed on the io thread,
+	// with pub_mtx_ held.
+	lp_mutex_t pub_mtx_;
+	size_t pub_nr_legs_ = 1;
+	bool pub_standby_ = false;
+	std::vector<PubLeg> pub_legs_;
+	// Subscribed symbol -> shard.
+	FlatStrMap<size_t> pub_subs_;
+	// Symbols per shard; shards past pub_nr_shards_ have no
+	// connections yet.
+	std::vector<size_t> pub_shard_subs_;
+	size_t pub_nr_shards_ = 0;
+	uint64_t pub_subs_changed_ns_ = 0;
+	OKXSubOpts sub_opts_;
+	bool pub_drain_pending_ = false;
 	WebsocketSession *wss_pri_ = nullptr;
 
-	inline void handlePubWsChan(void *a);
-	inline void handlePubWsChanMarkPrice(void *a);
-	inline void handlePubWsChanTickers(void *a);
+	struct SymState {
+		// Symbol table entry, taken at subscribe time.
+		uint32_t		id = 0;
+		std::string_view	name;
+		// Last delivered ts, only used with redundancy.
+		uint64_t	last_ts = 0;
+		// Steady clock of the subscribe call.
+		uint64_t	sub_ns = 0;
+		uint64_t	first_tick_ns = 0;
+		bool		acked = false;
+	};
+
+	// A listen call waiting for the server's answers.
+	struct SubRequest {
+		std::vector<std::string>	symbols;
+		size_t				nr_left = 0;
+		ExcSubResult			res;
+		SubDoneCb_t			done;
+	};
+
+	// Subscribed symbols, touched by every update.
+	lp_mutex_t sym_mtx_;
+	FlatStrMap<SymState> pub_syms_;
+	uint64_t nr_duplicates_ = 0;
+	// Symbols subscribed but without an update yet.
+	std::atomic<size_t> nr_awaiting_tick_{0};
+	LatencyHistogram sub_first_tick_;
+
+	// Under pub_mtx_.
+	FlatStrMap<std::vector<std::shared_ptr<SubRequest>>> pub_sub_waiters_;
+	// Unanswered symbols of the subscribe messages by request id.
+	std::map<uint64_t, std::vector<std::string>> pub_sub_ids_;
+	uint64_t pub_next_req_id_ = 1;
+	uint64_t nr_sub_errors_ = 0;
+	uint64_t nr_stale_reconnects_ = 0;
 
-	inline void handlePubWsOnWsConnect(void);
-	inline void handlePubWsOnWsWrite(size_t len);
-	inline size_t handlePubWsOnWsRead(const char *data, size_t len);
-	inline void handlePubWsOnWsClose(void);
+	WsHeartbeatOpts pub_hb_;
+	WsQueueOpts pub_queue_;
+	uint64_t stale_budget_ms_ = 0;
 
+	ConnClass conn_[2];
+	OKXProbeOpts probe_opts_;
+	size_t nr_probes_running_ = 0;
+
+	inline ConnClass &getConnClass(OKXConnClass cls) { return conn_[(size_t)cls]; }
+
+	inline void handlePubWsChan(void *a, size_t leg);
+	inline void handlePubWsChanPrice(void *a, size_t leg, const char *field);
+	inline void handlePubWsEvent(void *a);
+	void __subAnswered(const std::string &symbol, const std::string *err,
+			   std::vector<std::shared_ptr<SubRequest>> *done);
+	void __listenPub(const std::vector<std::string> &symbols);
+	void expireSubRequest(const std::shared_ptr<SubRequest> &req);
+	inline bool trackArrival(std::string_view sym, ExcPriceUpdate *pu, size_t leg);
+	inline size_t findPubLeg(WebsocketSession *ws_sess, bool *is_next);
+
+	inline void handlePubWsOnWsConnect(WebsocketSession *ws_sess);
+	inline void handlePubWsOnWsWrite(WebsocketSession *ws_sess, size_t len);
+	inline size_t handlePubWsOnWsRead(WebsocketSession *ws_sess, const char *data,
+					  size_t len);
+	inline void handlePubWsOnWsClose(WebsocketSession *ws_sess);
+	inline void handlePubWsOnWsConnErr(WebsocketSession *ws_sess);
+
+	WebsocketSession *createPubSession(const OKXEndpoint &ep);
+	void __addPubShard(void);
+	void growPub(void);
 	inline void startPubWs(void);
 	inline void startPriWs(void);
 
+	inline size_t __pickPubShard(void);
+	std::vector<std::string> __shardSubs(size_t shard);
+	void __queuePubReq(SubPacer &p, const char *op,
+			   const std::vector<std::string> &symbols);
+	void __queueShardReq(size_t shard, const char *op,
+			     const std::vector<std::string> &symbols);
+	inline void __drainPacer(WebsocketSession *ws_sess, SubPacer &p,
+				 uint64_t now, uint64_t *wait_ns);
+	inline void __kickPubDrain(void);
+	void drainPub(void);
+	void probeEndpoints(void);
+	void finishProbe(const std::shared_ptr<Probe> &pr, bool ok);
+	void maybeMigratePub(void);
+	void completeMigratePub(size_t leg);
+	void checkStale(void);
+
 protected:
 	virtual void __listenPriceUpdate(const std::string &symbol) override;
 	virtual void __unlistenPriceUpdate(const std::string &symbol) override;
 	virtual void __listenPriceUpdateBatch(const std::vector<std::string> &symbols) override;
 	virtual void __unlistenPriceUpdateBatch(const std::vector<std::string> &symbols) override;
+	virtual void __listenPriceUpdateBatchAck(const std::vector<std::string> &symbols,
+						 SubDoneCb_t done) override;
 
 public:
 	OKX(void);
 	virtual ~OKX(void);
 	virtual void start(void) override;
+
+	/*
+	 * Candidate endpoints of a connection class, the first one is
+	 * connected to on start(). Must be called before start().
+	 */
+	void setEndpoints(OKXConnClass cls, const std::vector<OKXEndpoint> &eps);
+	void setProbeOpts(const OKXProbeOpts &opts);
+	std::vector<OKXEndpointStats> getEndpointStats(OKXConnClass cls);
+
+	/*
+	 * Hold @nr_legs public connections with the same subscriptions
+	 * and deliver each (symbol, ts) from whichever has it first.
+	 * Must be called before start().
+	 */
+	void setPubRedundancy(size_t nr_legs);
+
+	/*
+	 * Chunking, pacing and per-connection cap of the public
+	 * subscriptions. Must be called before start().
+	 */
+	void setSubOpts(const OKXSubOpts &opts);
+
+	// False if @symbol is not in the subscription set.
+	bool getSubInfo(const std::string &symbol, OKXSubInfo *info);
+	// Subscribe call -> first update over all symbols.
+	const LatencyHistogram &getSubFirstTickHist(void) { return sub_first_tick_; }
+	// Error events, subscriptions rejected by the server among them.
+	uint64_t getNrSubErrors(void);
+
+	// Shards times redundancy, the index range of the per-leg getters.
+	size_t getNrPubConnections(void);
+
+	/*
+	 * Give every public connection a warm standby, see
+	 * WebsocketSession::setStandby(). Must be called before start().
+	 */
+	void setPubStandby(bool enable);
+	OKXHedgeStats getHedgeStats(void);
+
+	/*
+	 * "ping" / "pong" heartbeat of the public connections, see
+	 * WebsocketSession::setHeartbeat(). A connection found dead is
+	 * replaced and its subscriptions replayed. Defaults to a 1 s
+	 * interval and timeout. Must be called before start().
+	 */
+	void setPubHeartbeat(const WsHeartbeatOpts &opts);
+	const LatencyHistogram &getPubHeartbeatRtt(size_t leg);
+
+	/*
+	 * Outbound queue bound of the public connections, 1024 messages by
+	 * default. Single-symbol (un)subscribes coalesce while queued. A
+	 * refused subscribe is not lost: the subscription set is replayed
+	 * when the stalled connection is replaced. Must be called before
+	 * start().
+	 */
+	void setPubQueueOpts(const WsQueueOpts &opts);
+	WsQueueStats getPubQueueStats(size_t leg);
+
+	/*
+	 * Reconnect a public connection that is up and has subscriptions
+	 * but pushed no data for @ms, which catches a feed that stalls
+	 * while the connection still answers pings. Must exceed the normal
+	 * gap between pushes of the quietest connection. 0 (the default)
+	 * disables it.
+	 */
+	void setStaleBudget(uint64_t ms);
+	uint64_t getNrStaleReconnects(void);
 };
 
 } /* namespace exc_OKX */
@@ -0,0 +1,161 @@
+// SPDX-License-Identifier: GPL-2.0-only
+
+/*
+ * FlatStrMap against std::unordered_map under insert / erase / reinsert
+ * churn. Each case grows the map through several rehashes, or keeps it
+ * small and churns it until erased slots force a rebuild. After every
+ * round both maps must hold the same entries.
+ */
+
+#include <wbx/exc/FlatStrMap.hpp>
+
+#include <cstdio>
+#include <random>
+#include <string>
+#include <unordered_map>
+
+using namespace wbx::exc;
+
+struct ChurnCase {
+	const char	*name;
+	// Distinct keys the operations pick from.
+	size_t		nr_keys;
+	size_t		nr_rounds;
+	size_t		ops_per_round;
+	// Out of 100, the rest are inserts.
+	unsigned	erase_pct;
+	// Keys longer than the short-string buffer.
+	bool		long_keys;
+};
+
+static const ChurnCase cases[] = {
+	{ "grow, short keys",		4096,	8,	2048,	10,	false },
+	{ "grow, long keys",		4096,	8,	2048,	10,	true },
+	{ "steady state",		512,	32,	1024,	50,	false },
+	{ "erased slots, small map",	24,	64,	512,	50,	true },
+	{ "drain to empty",		1024,	16,	1024,	90,	false },
+};
+
+static int nr_failed;
+
+static void check(bool ok, const char *name, const char *what)
+{
+	printf("%s: %s: %s\n", ok ? "ok" : "FAIL", name, what);
+	if (!ok)
+		nr_failed++;
+}
+
+static std::string keyOf(size_t i, bool long_key)
+{
+	if (long_key)
+		return "SYM" + std::to_string(i) + "-USDT-250926-SWAP";
+
+	return "S" + std::to_string(i) + "-USDT";
+}
+
+// Same entries, found through find(), count() and iteration.
+static bool sameEntries(const FlatStrMap<int> &m,
+			const std::unordered_map<std::string, int> &ref,
+			const ChurnCase &c)
+{
+	size_t nr_iter = 0;
+
+	if (m.size() != ref.size() || m.empty() != ref.empty())
+		return false;
+
+	for (const auto &e : m) {
+		auto it = ref.find(e.first);
+
+		if (it == ref.end() || it->second != e.second)
+			return false;
+		nr_iter++;
+	}
+
+	if (nr_iter != ref.size())
+		return false;
+
+	for (size_t i = 0; i < c.nr_keys; i++) {
+		std::string key = keyOf(i, c.long_keys);
+		auto it = m.find(key);
+		bool in_ref = ref.count(key);
+
+		if (m.count(key) != (size_t)in_ref || (it != m.end()) != in_ref)
+			return false;
+		if (in_ref && it->second != ref.at(key))
+			return false;
+	}
+
+	return true;
+}
+
+static void runCase(const ChurnCase &c)
+{
+	std::unordered_map<std::string, int> ref;
+	std::mt19937 rng(1);
+	FlatStrMap<int> m;
+	bool ops_ok = true;
+	bool rounds_ok = true;
+	size_t i, r;
+	int val = 0;
+
+	for (r = 0; r < c.nr_rounds; r++) {
+		for (i = 0; i < c.ops_per_round; i++) {
+			std::string key = keyOf(rng() % c.nr_keys, c.long_keys);
+
+			if (rng() % 100 < c.erase_pct) {
+				if (m.erase(key) != ref.erase(key))
+					ops_ok = false;
+				continue;
+			}
+
+			auto res = m.emplace(key, ++val);
+			auto ref_res = ref.emplace(key, val);
+
+			if (res.second != ref_res.second ||
+			    res.first->first != key ||
+			    res.first->second != ref_res.first->second)
+				ops_ok = false;
+		}
+
+		if (!sameEntries(m, ref, c))
+			rounds_ok = false;
+	}
+
+	check(ops_ok, c.name, "emplace and erase results");
+	check(rounds_ok, c.name, "entries after every round");
+
+	// erase(iterator) while walking the table, every other entry.
+	bool skip = false;
+
+	for (auto it = m.begin(); it != m.end();) {
+		if (skip) {
+			++it;
+		} else {
+			ref.erase(it->first);
+			it = m.erase(it);
+		}
+		skip = !skip;
+	}
+	check(sameEntries(m, ref, c), c.name, "erase(iterator) while iterating");
+
+	// Everything erased comes back through operator[].
+	for (i = 0; i < c.nr_keys; i++) {
+		std::string key = keyOf(i, c.long_keys);
+
+		m[key] += 1;
+		ref[key] += 1;
+	}
+	check(sameEntries(m, ref, c), c.name, "reinsert through operator[]");
+
+	m.clear();
+	ref.clear();
+	check(sameEntries(m, ref, c), c.name, "clear");
+}
+
+int main(void)
+{
+	for (const ChurnCase &c : cases)
+		runCase(c);
+
+	return nr_failed ? 1 : 0;
+}
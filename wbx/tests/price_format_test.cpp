@@ -0,0 +1,118 @@
+// SPDX-License-Identifier: GPL-2.0-only
+
+/*
+ * parseFixed() and fmtFixed() must round trip the decimal strings the
+ * exchanges send, fail cleanly on a buffer one byte short, and reject
+ * anything that is not a non-negative decimal of at most 19 digits.
+ */
+
+#include <wbx/exc/PriceFormat.hpp>
+
+#include <cstdio>
+#include <cstring>
+#include <string>
+
+using namespace wbx::exc;
+
+struct RoundTrip {
+	const char	*str;
+	uint64_t	value;
+	uint32_t	scale;
+};
+
+static const RoundTrip round_trips[] = {
+	// scale 0
+	{ "0",				0,				0 },
+	{ "7",				7,				0 },
+	{ "104",			104,				0 },
+	// scale below the digit count
+	{ "104.3",			1043,				1 },
+	{ "67321.50",			6732150,			2 },
+	{ "1.000",			1000,				3 },
+	// scale at and above the digit count
+	{ "0.123",			123,				3 },
+	{ "0.000123",			123,				6 },
+	{ "0.0",			0,				1 },
+	{ "0.00000000",			0,				8 },
+	// 19 digits
+	{ "9999999999999999999",	9999999999999999999ull,		0 },
+	{ "1234567890.123456789",	1234567890123456789ull,		9 },
+	{ "0.0000000000000000001",	1,				19 },
+	{ "0.9999999999999999999",	9999999999999999999ull,		19 },
+};
+
+static const char *const rejects[] = {
+	"",
+	".",
+	"1.2.3",
+	"-1",
+	"+1",
+	"1e5",
+	" 1",
+	"1 ",
+	"0x10",
+	// 20 digits
+	"18446744073709551615",
+	"1234567890.1234567890",
+};
+
+static int nr_failed;
+
+static void check(bool ok, const char *what, const char *str)
+{
+	printf("%s: %s \"%s\"\n", ok ? "ok" : "FAIL", what, str);
+	if (!ok)
+		nr_failed++;
+}
+
+static void testRoundTrip(const RoundTrip &t)
+{
+	size_t len = strlen(t.str);
+	uint64_t value = ~0ull;
+	uint32_t scale = ~0u;
+	char buf[64];
+
+	check(parseFixed(t.str, &value, &scale) &&
+	      value == t.value && scale == t.scale, "parse", t.str);
+
+	check(fmtFixed(buf, sizeof(buf), t.value, t.scale) == len &&
+	      !strcmp(buf, t.str), "format", t.str);
+
+	// Room for the NUL is required.
+	check(fmtFixed(buf, len + 1, t.value, t.scale) == len,
+	      "format into an exact buffer", t.str);
+	check(!fmtFixed(buf, len, t.value, t.scale),
+	      "format into a short buffer", t.str);
+}
+
+static void testBulk(void)
+{
+	static const uint64_t values[] = { 1043, 7, 123 };
+	const char *out[3];
+	char buf[64];
+	size_t used;
+
+	used = fmtFixedBulk(buf, sizeof(buf), values, 3, 2, out);
+	check(used == sizeof("10.43") + sizeof("0.07") + sizeof("1.23") &&
+	      !strcmp(out[0], "10.43") && !strcmp(out[1], "0.07") &&
+	      !strcmp(out[2], "1.23"), "bulk format", "10.43 0.07 1.23");
+
+	check(!fmtFixedBulk(buf, used - 1, values, 3, 2, out),
+	      "bulk format into a short buffer", "10.43 0.07 1.23");
+}
+
+int main(void)
+{
+	uint64_t value;
+	uint32_t scale;
+
+	for (const RoundTrip &t : round_trips)
+		testRoundTrip(t);
+
+	for (const char *s : rejects)
+		check(!parseFixed(s, &value, &scale), "reject", s);
+
+	testBulk();
+
+	return nr_failed ? 1 : 0;
+}
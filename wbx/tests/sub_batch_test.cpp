@@ -0,0 +1,77 @@
+// SPDX-License-Identifier: GPL-2.0-only
+
+/*
+ * Batched listen / unlisten calls (ExchangeFoundation::setSubBatching())
+ * must end up in the state of the last call, whatever the exchange had
+ * before the batch.
+ */
+
+#include <wbx/exc/ExchangeFoundation.hpp>
+
+#include <cstdio>
+#include <set>
+#include <string>
+
+using namespace wbx::exc;
+
+class FakeExc : public ExchangeFoundation {
+protected:
+	void __listenPriceUpdate(const std::string &symbol) override
+	{
+		subs.insert(symbol);
+	}
+
+	void __unlistenPriceUpdate(const std::string &symbol) override
+	{
+		subs.erase(symbol);
+	}
+
+public:
+	std::set<std::string> subs;
+
+	~FakeExc(void) { stopShards(); }
+	void start(void) override {}
+};
+
+static void noop_cb(ExchangeFoundation *ef, const ExcPriceUpdate &up, void *udata)
+{
+	(void)ef;
+	(void)up;
+	(void)udata;
+}
+
+static int nr_failed;
+
+static void check(bool ok, const char *what)
+{
+	printf("%s: %s\n", ok ? "ok" : "FAIL", what);
+	if (!ok)
+		nr_failed++;
+}
+
+int main(void)
+{
+	FakeExc exc;
+
+	exc.setWebsocket(std::make_shared<Websocket>());
+
+	// Not subscribed: the unlisten is a no-op, the listen must stay.
+	exc.unlistenPriceUpdate("BTC-USDT");
+	exc.listenPriceUpdate("BTC-USDT", noop_cb, nullptr);
+	exc.flushSubChanges();
+	check(exc.subs.count("BTC-USDT") == 1, "unlisten -> listen subscribes");
+
+	// Subscribed: the listen is a no-op, the unlisten must stay.
+	exc.listenPriceUpdate("BTC-USDT", noop_cb, nullptr);
+	exc.unlistenPriceUpdate("BTC-USDT");
+	exc.flushSubChanges();
+	check(exc.subs.count("BTC-USDT") == 0, "listen -> unlisten unsubscribes");
+
+	exc.listenPriceUpdate("ETH-USDT", noop_cb, nullptr);
+	exc.unlistenPriceUpdate("ETH-USDT");
+	exc.listenPriceUpdate("ETH-USDT", noop_cb, nullptr);
+	exc.flushSubChanges();
+	check(exc.subs.count("ETH-USDT") == 1, "listen -> unlisten -> listen subscribes");
+
+	return nr_failed ? 1 : 0;
+}